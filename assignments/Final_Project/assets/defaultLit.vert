@@ -2,6 +2,9 @@
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
+// ew::Mesh vertex format constants, set by Mesh::draw. xyz dequantizes 16 bit positions, w is 1 for octahedral normals
+layout(location = 3) in vec4 vPositionScale;
+layout(location = 4) in vec3 vPositionOffset;
 
 out Surface{
 	vec2 UV;
@@ -11,18 +14,29 @@ out Surface{
 }vs_out;
 
 uniform mat4 _Model;
+uniform mat3 _NormalMatrix; //transpose(inverse(mat3(_Model))), computed on the CPU
 uniform mat4 _ViewProjection;
 
 out vec3 cameraVector;
 
+vec3 decodeNormal(){
+	if (vPositionScale.w == 0.0)
+		return vNormal;
+	vec3 n = vec3(vNormal.xy, 1.0 - abs(vNormal.x) - abs(vNormal.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
 void main(){
+	vec3 pos = vPos * vPositionScale.xyz + vPositionOffset;
 	vs_out.UV = vUV;
 
-	vs_out.yPos = (vPos.y/10);
+	vs_out.yPos = (pos.y/10);
 	
-	vs_out.worldPosition = vec3( _Model * vec4(vPos,1.0));
-	cameraVector = vPos* mat3(_ViewProjection);
-	vs_out.worldNormal = transpose(inverse(mat3(_Model)))*vNormal;
+	vs_out.worldPosition = vec3( _Model * vec4(pos,1.0));
+	cameraVector = pos* mat3(_ViewProjection);
+	vs_out.worldNormal = _NormalMatrix*decodeNormal();
 
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
+	gl_Position = _ViewProjection * _Model * vec4(pos,1.0);
 }
\ No newline at end of file
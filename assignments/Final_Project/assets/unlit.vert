@@ -2,11 +2,19 @@
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
+// ew::Mesh vertex format constants, set by Mesh::draw. xyz dequantizes 16 bit positions, w is 1 for octahedral normals
+layout(location = 3) in vec4 vPositionScale;
+layout(location = 4) in vec3 vPositionOffset;
+// ew::InstanceData, one per instance drawn by Mesh::drawInstanced
+layout(location = 5) in mat4 iModel;
+layout(location = 9) in vec4 iColor;
 
-uniform mat4 _Model;
 uniform mat4 _ViewProjection;
 
+out vec3 Color;
+
 void main()
 {
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
+	Color = iColor.rgb;
+	gl_Position = _ViewProjection * iModel * vec4(vPos * vPositionScale.xyz + vPositionOffset,1.0);
 }
\ No newline at end of file
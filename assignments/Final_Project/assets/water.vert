@@ -2,6 +2,9 @@
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
+// ew::Mesh vertex format constants, set by Mesh::draw. xyz dequantizes 16 bit positions, w is 1 for octahedral normals
+layout(location = 3) in vec4 vPositionScale;
+layout(location = 4) in vec3 vPositionOffset;
 
 out Surface{
 	vec2 UV;
@@ -12,23 +15,34 @@ out Surface{
 
 
 uniform mat4 _Model;
+uniform mat3 _NormalMatrix; //transpose(inverse(mat3(_Model))), computed on the CPU
 uniform mat4 _ViewProjection;
 
 // Natalie Basile water vertex shader variables
 uniform float amplitude, wavelength, speed, time;
 uniform vec2 direction;
 
+vec3 decodeNormal(){
+	if (vPositionScale.w == 0.0)
+		return vNormal;
+	vec3 n = vec3(vNormal.xy, 1.0 - abs(vNormal.x) - abs(vNormal.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
 
 void main()
 {
 	vs_out.UV = vUV;
 
 	// Natalie Basile water vertex shader
-	vec3 newPos = vPos;
+	vec3 pos = vPos * vPositionScale.xyz + vPositionOffset;
+	vec3 newPos = pos;
 	newPos.y += cos(vUV.x * wavelength + speed * time) * amplitude + sin(vUV.y * wavelength + speed * time) * amplitude;
 
-	vs_out.worldPosition = vec3( _Model * vec4(vPos,1.0));
-	vs_out.worldNormal = transpose(inverse(mat3(_Model)))*vNormal;
+	vs_out.worldPosition = vec3( _Model * vec4(pos,1.0));
+	vs_out.worldNormal = _NormalMatrix*decodeNormal();
 
 	gl_Position = _ViewProjection * _Model * vec4(newPos, 1.0);
 }
\ No newline at end of file
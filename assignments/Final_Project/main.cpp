@@ -12,15 +12,24 @@
 #include <ew/shader.h>
 #include <ew/texture.h>
 #include <ew/procGen.h>
+#include <ew/meshOptimize.h>
+#include <ew/meshArena.h>
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
+#include <ew/ewMath/frustum.h>
+#include <ew/threadPool.h>
 #include <wm/texture.h>
 #include <wm/perlinNoise.h>
 #include <wm/procGen.h>
+#include <wm/landBuilder.h>
+#include <wm/landChunks.h>
+#include <wm/landCache.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void resetCamera(ew::Camera& camera, ew::CameraController& cameraController);
+bool isVisible(const ew::Frustum& frustum, const ew::AABB& worldBounds);
+void measureLandUploads(const ew::MeshData& landA, const ew::MeshData& landB, const ew::VertexFormat& format, float& staticMs, float& dynamicMs);
 
 int SCREEN_WIDTH = 1080;
 int SCREEN_HEIGHT = 720;
@@ -44,6 +53,35 @@ int numberOfLights = 1;
 
 bool orbit = false;
 
+// Frustum culling toggle and per frame counters shown in the UI
+bool frustumCulling = true;
+int numDrawn = 0;
+int numCulled = 0;
+
+// Draws the water plane as triangle strips with primitive restart instead of triangle lists
+bool waterStrips = false;
+
+// Instancing stress test: STRESS_CUBES cubes in one draw call
+const int STRESS_CUBES = 100000;
+bool stressCubes = false;
+
+// Mesh arena demo: NUM_PROPS props sharing PROP_MESHES different meshes, drawn with one multi-draw-indirect per frame
+const int NUM_PROPS = 2000;
+const int PROP_MESHES = 24;
+bool drawProps = false;
+
+ew::MeshData createPropMesh(int variant)
+{
+	switch (variant % 3) {
+	case 0:
+		return ew::createSphere(0.3f, 4 + variant % 13);
+	case 1:
+		return ew::createCylinder(0.2f, 0.6f, 3 + variant % 17);
+	default:
+		return wm::createTorus(0.1f, 0.3f, 6 + variant % 11, 4 + variant % 7);
+	}
+}
+
 struct Material
 {
 	// Will Mansfield added rim lighting variables
@@ -114,10 +152,52 @@ int main() {
 	ew::Shader waterShader("assets/water.vert", "assets/water.frag");
 
 	// define unlit spehere mesh
-	ew::Mesh unlitShpereMesh(ew::createSphere(0.2, 10));
+	// Generated meshes are reordered once for the GPU's post-transform vertex cache before upload
+	ew::MeshData unlitSphereData = ew::createSphere(0.2, 10);
+	ew::OptimizeMesh(unlitSphereData);
+	ew::Mesh unlitShpereMesh(unlitSphereData);
+
+	// A grid of small cubes floating over the land, filled once and drawn as instances with the unlit shader
+	ew::Mesh stressCubeMesh(ew::createCube(0.08f));
+	ew::InstanceBuffer stressCubeInstances;
+	stressCubeInstances.reserve(STRESS_CUBES);
+	const int stressSide = (int)ceilf(sqrtf((float)STRESS_CUBES));
+	for (int i = 0; i < STRESS_CUBES; i++)
+	{
+		ew::Transform cube;
+		cube.position = ew::Vec3(-20.0f + 40.0f * (i % stressSide + 0.5f) / stressSide, 4.0f + sinf(i * 0.37f), -20.0f + 40.0f * (i / stressSide + 0.5f) / stressSide);
+		cube.rotation = ew::Vec3(0.0f, (float)(i % 90), 0.0f);
+		stressCubeInstances.add(cube, ew::Vec4((float)(i % stressSide) / stressSide, 0.5f, (float)(i / stressSide) / stressSide, 1.0f));
+	}
+
+	// The big grids use 16 byte vertices (16 bit positions, octahedral normals, 16 bit UVs) instead of 32, decoded in the vertex shaders
+	const ew::VertexFormat compactFormat = { ew::PositionFormat::UNORM16, ew::NormalFormat::OCT16, ew::UVFormat::UNORM16 };
 
 	// Natalie Basile created waterPlaneMesh + Transform w/position + Material values
-	ew::Mesh waterPlaneMesh(ew::createPlane(40.0f, 40.0f, 400)); // New water plane for water shaders
+	ew::MeshData waterPlaneData = ew::createPlane(40.0f, 40.0f, 400);
+	ew::MeshOptimizeReport waterReport = ew::OptimizeMesh(waterPlaneData);
+	printf("Water plane vertex cache: ACMR %.2f -> %.2f, ATVR %.2f -> %.2f\n", waterReport.before.acmr, waterReport.after.acmr, waterReport.before.atvr, waterReport.after.atvr);
+	ew::Mesh waterPlaneMesh(waterPlaneData, compactFormat); // New water plane for water shaders
+	// The same plane as strips, a third of the indices
+	ew::MeshData waterStripData = waterPlaneData;
+	waterStripData.indices = ew::StripifyMesh(waterPlaneData);
+	ew::Mesh waterStripMesh(waterStripData, compactFormat);
+
+	// Every prop mesh lives in one arena. Prop i uses mesh i % PROP_MESHES
+	ew::MeshArena propArena(compactFormat);
+	int propMeshIds[PROP_MESHES];
+	int nextPropVariant = 0;
+	for (int m = 0; m < PROP_MESHES; m++)
+	{
+		propMeshIds[m] = propArena.add(createPropMesh(nextPropVariant++));
+	}
+	std::vector<ew::Transform> propTransforms(NUM_PROPS);
+	for (int i = 0; i < NUM_PROPS; i++)
+	{
+		propTransforms[i].position = ew::Vec3(-19.0f + fmodf(i * 7.31f, 38.0f), 2.0f + fmodf(i * 0.53f, 4.0f), -19.0f + fmodf(i * 3.17f, 38.0f));
+		propTransforms[i].rotation = ew::Vec3(fmodf(i * 37.0f, 360.0f), fmodf(i * 53.0f, 360.0f), 0.0f);
+	}
+
 	ew::Transform waterPlaneTransform; // transform for water plan
 	waterPlaneTransform.position = ew::Vec3(0.0, -1.05, 0); // setting pos for water plane transform
 	wave.material.ambientK = 0.1;
@@ -128,6 +208,8 @@ int main() {
 	wave.material.rimAmbientIntestiy = 4;
 
 	ew::Transform unLitsphereTransfrom[MAX_LIGHTS];
+	// Visible light spheres, refilled every frame and drawn with one instanced draw
+	ew::InstanceBuffer unlitSphereInstances;
 
 	unLitsphereTransfrom[0].position = ew::Vec3(0.0, 10, -10.0);
 	unLitsphereTransfrom[1].position = ew::Vec3(0.0, 10, 10.0);
@@ -136,7 +218,21 @@ int main() {
 
 	// Izzy defined land mesh, transform, position
 	int seed = 300;
-	ew::Mesh* landMesh = new ew::Mesh(wm::createLand(40.0f, 400, seed)); // last variable is seed for generation
+	ew::ThreadPool threadPool; // Land generation is split across every hardware thread
+	// Lands already generated once, by this run or an earlier one, are mapped from landCache/ instead of generated again
+	wm::LandCache landCache("landCache");
+	wm::LandCacheKey landKey = { 40.0f, 400, seed, wm::LandSettings() }; // seed is the third value
+	ew::Mesh* landMesh = new ew::Mesh();
+	landCache.get(landKey, &threadPool)->upload(*landMesh, compactFormat);
+	// New seeds are generated in the background, a 50x50 preview first, and uploaded into the mesh that isn't being drawn
+	wm::LandBuilder landBuilder(40.0f, 400, 50, wm::LandSettings(), &threadPool, &landCache, compactFormat);
+	ew::Mesh* landBackMesh = new ew::Mesh();
+	bool landPreview = false;
+	// Endless alternative to the single land mesh: 10x10 chunks with the same vertex spacing, streamed in around the camera
+	bool streamLand = false;
+	float staticUploadMs = 0.0f;
+	float dynamicUploadMs = 0.0f;
+	wm::LandChunks landChunks(10.0f, 100, seed, 5, 96 * 1024 * 1024, &threadPool, compactFormat);
 	ew::Transform landTransform;
 	landTransform.position = ew::Vec3(-20.0f, -6.0f, 20.0f);
 
@@ -166,10 +262,26 @@ int main() {
 		camera.aspectRatio = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
 		cameraController.Move(window, &camera, deltaTime);
 
+		// Swap in land finished by the builder since last frame
+		wm::LandResult landResult;
+		if (landBuilder.poll(landResult)) {
+			landResult.upload(*landBackMesh);
+			std::swap(landMesh, landBackMesh);
+			landPreview = landResult.isPreview;
+		}
+		if (streamLand) {
+			landChunks.update(camera.position - landTransform.position);
+		}
+
 		//RENDER
 		glClearColor(bgColor.x, bgColor.y, bgColor.z, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		ew::Mat4 viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+		ew::Frustum frustum = ew::ExtractFrustum(viewProjection);
+		numDrawn = 0;
+		numCulled = 0;
+
 		// Izzy created shader for mountains 
 		shader.use();
 		glActiveTexture(GL_TEXTURE0);
@@ -182,12 +294,21 @@ int main() {
 		shader.setInt("_CellTexture", 1);
 
 		//shader model
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		shader.setMat4("_ViewProjection", viewProjection);
 		shader.setVec3("cameraTarget", camera.target);
 
 		// Izzy draws land
 		shader.setMat4("_Model", landTransform.getModelMatrix());
-		landMesh->draw();
+		shader.setMat3("_NormalMatrix", landTransform.getNormalMatrix());
+		if (streamLand) {
+			landChunks.draw(shader, landTransform.getModelMatrix(), frustum, frustumCulling);
+			wm::LandChunksStats chunkStats = landChunks.getStats();
+			numDrawn += chunkStats.numDrawn;
+			numCulled += chunkStats.numCulled;
+		}
+		else if (isVisible(frustum, ew::TransformAABB(landMesh->getBounds(), landTransform.getModelMatrix()))) {
+			landMesh->draw();
+		}
 		
 		// Will sets positions and colors for lights
 		for (int i = 0; i < numberOfLights; i++)
@@ -214,20 +335,42 @@ int main() {
 
 		// unlit shader
 		unlitShader.use();
-		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		unlitShader.setMat4("_ViewProjection", viewProjection);
 
-		// draw unlit lights
+		// draw unlit lights, every visible light is one instance of a single instanced draw
+		unlitSphereInstances.clear();
 		for (int i = 0; i < numberOfLights; i++)
 		{
-			unlitShader.setMat4("_Model", unLitsphereTransfrom[i].getModelMatrix());
-			unlitShader.setVec3("_Color", lights[i].color);
-			unlitShpereMesh.draw();
+			if (!isVisible(frustum, ew::TransformAABB(unlitShpereMesh.getBounds(), unLitsphereTransfrom[i].getModelMatrix()))) {
+				continue;
+			}
+			unlitSphereInstances.add(unLitsphereTransfrom[i], ew::Vec4(lights[i].color, 1.0f));
+		}
+		unlitShpereMesh.drawInstanced(unlitSphereInstances);
+		if (stressCubes) {
+			stressCubeMesh.drawInstanced(stressCubeInstances);
+		}
+		// Visible props queued mesh by mesh, so each mesh is one indirect command however many of its props are drawn
+		if (drawProps) {
+			for (int m = 0; m < PROP_MESHES; m++)
+			{
+				const ew::Vec4 color = ew::Vec4(0.4f + 0.6f * (m % 3) / 2.0f, 0.4f + 0.6f * (m % 4) / 3.0f, 0.4f + 0.6f * (m % 5) / 4.0f, 1.0f);
+				for (int i = m; i < NUM_PROPS; i += PROP_MESHES)
+				{
+					if (frustumCulling && !isVisible(frustum, ew::TransformAABB(propArena.getBounds(propMeshIds[m]), propTransforms[i].getModelMatrix()))) {
+						continue;
+					}
+					propArena.queue(propMeshIds[m], propTransforms[i], color);
+				}
+			}
+			propArena.drawQueued();
 		}
 
 		// Natalie created water shader
 		waterShader.use();
-		waterShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		waterShader.setMat4("_ViewProjection", viewProjection);
 		waterShader.setMat4("_Model", waterPlaneTransform.getModelMatrix());
+		waterShader.setMat3("_NormalMatrix", waterPlaneTransform.getNormalMatrix());
 
 		// Natalie added water texture
 		glActiveTexture(GL_TEXTURE0);
@@ -272,7 +415,18 @@ int main() {
 		waterShader.setVec3("cameraPos", camera.position);
 		
 		// Natalie draws water
-		waterPlaneMesh.draw();
+		// The vertex shader displaces y by up to 2 * amplitude, so grow the bounds to match
+		ew::AABB waterBounds = waterPlaneMesh.getBounds();
+		waterBounds.min.y -= 2.0f * fabsf(wave.amplitude);
+		waterBounds.max.y += 2.0f * fabsf(wave.amplitude);
+		if (isVisible(frustum, ew::TransformAABB(waterBounds, waterPlaneTransform.getModelMatrix()))) {
+			if (waterStrips) {
+				waterStripMesh.draw(ew::DrawMode::TRIANGLE_STRIP);
+			}
+			else {
+				waterPlaneMesh.draw();
+			}
+		}
 
 		// Render UI
 		{
@@ -342,6 +496,8 @@ int main() {
 				ImGui::DragFloat("wavelength", &wave.wavelength, 0.05f);
 				ImGui::DragFloat("speed", &wave.speed, 0.05f);
 				ImGui::DragInt("tiling", &wave.numWaves, 0.05f);
+				ImGui::Checkbox("triangle strips", &waterStrips);
+				ImGui::Text("Indices: %d", waterStrips ? waterStripMesh.getNumIndices() : waterPlaneMesh.getNumIndices());
 
 				// Will added water material GUI
 				if (ImGui::CollapsingHeader("water material"))
@@ -359,9 +515,60 @@ int main() {
 			if (ImGui::CollapsingHeader("Land")) {
 				if (ImGui::DragInt("seed", &seed))
 				{
-					delete landMesh;
-					landMesh = new ew::Mesh(wm::createLand(40.0f, 400, seed));
+					landBuilder.request(seed);
+					landChunks.setSeed(seed);
+				}
+				if (landBuilder.isBusy() || landPreview) {
+					ImGui::Text(landPreview ? "Generating... (preview)" : "Generating...");
+				}
+				wm::LandCacheStats cacheStats = landCache.getStats();
+				ImGui::Text("Cache hits: %d memory, %d disk. Misses: %d", cacheStats.memoryHits, cacheStats.diskHits, cacheStats.misses);
+				ImGui::Checkbox("Stream chunks", &streamLand);
+				if (streamLand) {
+					wm::LandChunksStats chunkStats = landChunks.getStats();
+					ImGui::Text("Chunks loaded: %d pending: %d", chunkStats.numLoaded, chunkStats.numPending);
+					ImGui::Text("Chunk memory: %.1f MB", chunkStats.gpuBytes / (1024.0f * 1024.0f));
+				}
+				// Reseeding cost of the 401x401 land: reloading a static mesh vs rewriting a dynamic one in place
+				if (ImGui::Button("Measure land upload")) {
+					ew::MeshData landA = wm::createLand(40.0f, 400, seed, wm::LandSettings(), &threadPool);
+					ew::MeshData landB = wm::createLand(40.0f, 400, seed + 1, wm::LandSettings(), &threadPool);
+					measureLandUploads(landA, landB, compactFormat, staticUploadMs, dynamicUploadMs);
 				}
+				if (staticUploadMs > 0.0f) {
+					ImGui::Text("Upload: static %.2f ms, dynamic %.2f ms", staticUploadMs, dynamicUploadMs);
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Instancing")) {
+				ImGui::Checkbox("100k cubes", &stressCubes);
+				ImGui::Text("Light spheres: %d instances, 1 draw call", unlitSphereInstances.size());
+			}
+
+			if (ImGui::CollapsingHeader("Mesh arena")) {
+				ImGui::Checkbox("props", &drawProps);
+				ew::MeshArenaStats arenaStats = propArena.getStats();
+				ImGui::Text("%d meshes, %d commands, %d instances", arenaStats.numMeshes, arenaStats.numCommands, arenaStats.numInstances);
+				ImGui::Text("Vertices: %.1f / %.1f KB, %d free blocks", arenaStats.vertexBytesUsed / 1024.0f, arenaStats.vertexBytesCapacity / 1024.0f, arenaStats.vertexFreeBlocks);
+				ImGui::Text("Indices: %.1f / %.1f KB, %d free blocks", arenaStats.indexBytesUsed / 1024.0f, arenaStats.indexBytesCapacity / 1024.0f, arenaStats.indexFreeBlocks);
+				ImGui::Text("Grows: %d Defragments: %d", arenaStats.numGrows, arenaStats.numDefragments);
+				// Swaps a few meshes for new ones of other sizes, leaving holes in the arena
+				if (ImGui::Button("Replace meshes")) {
+					for (int m = nextPropVariant % 4; m < PROP_MESHES; m += 4)
+					{
+						propArena.remove(propMeshIds[m]);
+						propMeshIds[m] = propArena.add(createPropMesh(nextPropVariant++));
+					}
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("Defragment")) {
+					propArena.defragment();
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Culling")) {
+				ImGui::Checkbox("Frustum culling", &frustumCulling);
+				ImGui::Text("Drawn: %d Culled: %d", numDrawn, numCulled);
 			}
 
 			ImGui::ColorEdit3("BG color", &bgColor.x);
@@ -374,6 +581,7 @@ int main() {
 		glfwSwapBuffers(window);
 	}
 	delete landMesh;
+	delete landBackMesh;
 	printf("Shutting down...");
 }
 
@@ -397,3 +605,46 @@ void resetCamera(ew::Camera& camera, ew::CameraController& cameraController) {
 	cameraController.pitch = 0.0f;
 }
 
+// Tests world space bounds against the camera frustum and updates the drawn/culled counters
+bool isVisible(const ew::Frustum& frustum, const ew::AABB& worldBounds)
+{
+	bool visible = !frustumCulling || ew::IsVisible(frustum, worldBounds);
+	if (visible) {
+		numDrawn++;
+	}
+	else {
+		numCulled++;
+	}
+	return visible;
+}
+
+// Average time to replace every vertex of a land, alternating between two seeds. glFinish makes the driver's copy part of the time
+void measureLandUploads(const ew::MeshData& landA, const ew::MeshData& landB, const ew::VertexFormat& format, float& staticMs, float& dynamicMs)
+{
+	const int ITERATIONS = 20;
+	const ew::AABB boundsA = ew::CalculateBounds(landA);
+	const ew::AABB boundsB = ew::CalculateBounds(landB);
+	ew::Mesh staticMesh;
+	staticMesh.load(landA.vertices.data(), (int)landA.vertices.size(), landA.indices.data(), (int)landA.indices.size(), boundsA, format);
+	ew::Mesh dynamicMesh;
+	dynamicMesh.loadDynamic(landA, format);
+	glFinish();
+
+	double start = glfwGetTime();
+	for (int i = 0; i < ITERATIONS; i++)
+	{
+		const ew::MeshData& land = i % 2 ? landA : landB;
+		staticMesh.load(land.vertices.data(), (int)land.vertices.size(), land.indices.data(), (int)land.indices.size(), i % 2 ? boundsA : boundsB, format);
+		glFinish();
+	}
+	staticMs = (float)((glfwGetTime() - start) * 1000.0 / ITERATIONS);
+
+	start = glfwGetTime();
+	for (int i = 0; i < ITERATIONS; i++)
+	{
+		const ew::MeshData& land = i % 2 ? landA : landB;
+		dynamicMesh.updateVertices(0, land.vertices.data(), (int)land.vertices.size());
+		glFinish();
+	}
+	dynamicMs = (float)((glfwGetTime() - start) * 1000.0 / ITERATIONS);
+}
@@ -10,6 +10,7 @@ out Surface{
 }vs_out;
 
 uniform mat4 _Model;
+uniform mat3 _NormalMatrix; //transpose(inverse(mat3(_Model))), computed on the CPU
 uniform mat4 _ViewProjection;
 
 out vec3 cameraVector;
@@ -21,7 +22,7 @@ void main(){
 	
 	vs_out.worldPosition = mat3(_Model)* vPos;
 	cameraVector = vPos* mat3(_ViewProjection);
-	vs_out.worldNormal = transpose(inverse(mat3(_Model)))*vNormal;
+	vs_out.worldNormal = _NormalMatrix*vNormal;
 
 	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
 }
\ No newline at end of file
@@ -151,15 +151,19 @@ int main() {
 
 		//Draw shapes
 		shader.setMat4("_Model", cubeTransform.getModelMatrix());
+		shader.setMat3("_NormalMatrix", cubeTransform.getNormalMatrix());
 		cubeMesh.draw();
 
 		shader.setMat4("_Model", planeTransform.getModelMatrix());
+		shader.setMat3("_NormalMatrix", planeTransform.getNormalMatrix());
 		planeMesh.draw();
 
 		shader.setMat4("_Model", sphereTransform.getModelMatrix());
+		shader.setMat3("_NormalMatrix", sphereTransform.getNormalMatrix());
 		sphereMesh.draw();
 
 		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
+		shader.setMat3("_NormalMatrix", cylinderTransform.getNormalMatrix());
 		cylinderMesh.draw();
 
 		for (int i = 0; i < numberOfLights; i++)
@@ -0,0 +1,137 @@
+#include "bench.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+//Global allocation counters. Replacing operator new lets every benchmark report allocations per op.
+static std::atomic<uint64_t> s_allocationCount(0);
+static std::atomic<uint64_t> s_allocationBytes(0);
+
+void* operator new(size_t size)
+{
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace bench {
+	static std::vector<Benchmark>& registry() {
+		static std::vector<Benchmark> benchmarks;
+		return benchmarks;
+	}
+
+	void add(const std::string& name, double itemsPerOp, Function run)
+	{
+		registry().push_back(Benchmark{ name, itemsPerOp, run });
+	}
+
+	uint64_t allocationCount()
+	{
+		return s_allocationCount.load(std::memory_order_relaxed);
+	}
+	uint64_t allocationBytes()
+	{
+		return s_allocationBytes.load(std::memory_order_relaxed);
+	}
+
+	static double timeMs(const Function& run, uint64_t iterations) {
+		auto start = std::chrono::steady_clock::now();
+		run(iterations);
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	/// <summary>
+	/// Grows the iteration count until one run takes at least minTimeMs, then reports the best of three runs.
+	/// </summary>
+	static Result measure(const Benchmark& benchmark, double minTimeMs) {
+		//Warm up caches and lazy initialization
+		benchmark.run(1);
+
+		uint64_t iterations = 1;
+		double elapsed = timeMs(benchmark.run, iterations);
+		while (elapsed < minTimeMs && iterations < (1ull << 40))
+		{
+			double scale = elapsed > 0.0 ? (minTimeMs * 1.2) / elapsed : 100.0;
+			scale = scale > 100.0 ? 100.0 : (scale < 2.0 ? 2.0 : scale);
+			iterations = (uint64_t)(iterations * scale);
+			elapsed = timeMs(benchmark.run, iterations);
+		}
+
+		double best = elapsed;
+		uint64_t allocations = allocationCount();
+		uint64_t bytes = allocationBytes();
+		for (int i = 0; i < 2; i++)
+		{
+			double t = timeMs(benchmark.run, iterations);
+			best = t < best ? t : best;
+		}
+		allocations = allocationCount() - allocations;
+		bytes = allocationBytes() - bytes;
+
+		Result result;
+		result.name = benchmark.name;
+		result.iterations = iterations;
+		result.nsPerOp = best * 1e6 / iterations;
+		result.itemsPerSecond = benchmark.itemsPerOp * iterations / (best * 1e-3);
+		result.allocsPerOp = (double)allocations / (2.0 * iterations);
+		result.bytesPerOp = (double)bytes / (2.0 * iterations);
+		return result;
+	}
+
+	std::vector<Result> runAll(const std::string& filter, double minTimeMs)
+	{
+		std::vector<Result> results;
+		for (const Benchmark& benchmark : registry())
+		{
+			if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+				continue;
+			results.push_back(measure(benchmark, minTimeMs));
+			printf(".");
+			fflush(stdout);
+		}
+		printf("\n");
+		return results;
+	}
+
+	void printTable(const std::vector<Result>& results)
+	{
+		printf("%-48s %14s %16s %12s %14s\n", "benchmark", "ns/op", "items/s", "allocs/op", "bytes/op");
+		for (const Result& r : results)
+		{
+			printf("%-48s %14.1f %16.4g %12.2f %14.1f\n", r.name.c_str(), r.nsPerOp, r.itemsPerSecond, r.allocsPerOp, r.bytesPerOp);
+		}
+	}
+
+	bool writeJson(const std::vector<Result>& results, const std::string& path)
+	{
+		FILE* file = fopen(path.c_str(), "w");
+		if (!file) {
+			printf("Failed to open %s for writing\n", path.c_str());
+			return false;
+		}
+		fprintf(file, "{\n\t\"benchmarks\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			fprintf(file, "\t\t{ \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"items_per_second\": %.6g, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f }%s\n",
+				r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp, r.itemsPerSecond, r.allocsPerOp, r.bytesPerOp, i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "\t]\n}\n");
+		fclose(file);
+		return true;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace bench {
+	/// <summary>
+	/// Benchmark body. Must perform the measured operation iterations times.
+	/// </summary>
+	using Function = std::function<void(uint64_t iterations)>;
+
+	struct Benchmark {
+		std::string name;
+		double itemsPerOp; //Items processed by one iteration (vertices, samples...), used for throughput
+		Function run;
+	};
+
+	struct Result {
+		std::string name;
+		uint64_t iterations;
+		double nsPerOp;
+		double itemsPerSecond;
+		double allocsPerOp;
+		double bytesPerOp;
+	};
+
+	/// <summary>
+	/// Registers a benchmark. Names are grouped with '/', e.g. "ewMath/Mat4*Mat4".
+	/// </summary>
+	void add(const std::string& name, double itemsPerOp, Function run);
+
+	/// <summary>
+	/// Runs every registered benchmark whose name contains filter.
+	/// </summary>
+	/// <param name="minTimeMs">Minimum measured time per repetition</param>
+	std::vector<Result> runAll(const std::string& filter, double minTimeMs);
+
+	void printTable(const std::vector<Result>& results);
+	bool writeJson(const std::vector<Result>& results, const std::string& path);
+
+	//Heap allocations since program start, counted by the global operator new replacement in bench.cpp
+	uint64_t allocationCount();
+	uint64_t allocationBytes();
+
+	/// <summary>
+	/// Keeps the compiler from optimizing away a value that is otherwise unused.
+	/// </summary>
+	template<typename T>
+	inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+}
@@ -0,0 +1,515 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdio.h>
+#include <math.h>
+
+#include "bench.h"
+
+//Draw benchmarks need a GL context without a window, made with EGL when CMake found it.
+//On Mesa, LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe, which runs vertex and index processing on the CPU
+#ifdef CORE_BENCH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <ew/external/glad.h>
+#include <ew/mesh.h>
+#include <ew/procGen.h>
+#include <ew/meshOptimize.h>
+#include <ew/meshArena.h>
+#include <ew/ewMath/transformations.h>
+#include <wm/procGen.h>
+
+static const int TARGET_SIZE = 512;
+
+//Maps a 10x10 plane in XZ onto the target
+static const char* PLANE_VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec3 vPos;
+void main() {
+	gl_Position = vec4(vPos.xz * 0.19, 0.0, 1.0);
+}
+)";
+//One model matrix per draw
+static const char* MODEL_VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec3 vPos;
+uniform mat4 _Model;
+void main() {
+	gl_Position = _Model * vec4(vPos, 1.0);
+}
+)";
+//ew::InstanceData attributes
+static const char* INSTANCED_VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec3 vPos;
+layout(location = 5) in mat4 iModel;
+layout(location = 9) in vec4 iData;
+out vec4 color;
+void main() {
+	color = iData;
+	gl_Position = iModel * vec4(vPos, 1.0);
+}
+)";
+//Normal matrix recomputed by every vertex, as the shaders did before _NormalMatrix
+static const char* INVERSE_NORMAL_VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+uniform mat4 _Model;
+out vec3 worldNormal;
+void main() {
+	worldNormal = transpose(inverse(mat3(_Model))) * vNormal;
+	gl_Position = _Model * vec4(vPos, 1.0);
+}
+)";
+//Normal matrix computed once on the CPU
+static const char* UNIFORM_NORMAL_VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+uniform mat4 _Model;
+uniform mat3 _NormalMatrix;
+out vec3 worldNormal;
+void main() {
+	worldNormal = _NormalMatrix * vNormal;
+	gl_Position = _Model * vec4(vPos, 1.0);
+}
+)";
+static const char* NORMAL_FRAGMENT_SHADER = R"(#version 330 core
+in vec3 worldNormal;
+out vec4 FragColor;
+void main() {
+	FragColor = vec4(normalize(worldNormal) * 0.5 + 0.5, 1.0);
+}
+)";
+static const char* WHITE_FRAGMENT_SHADER = R"(#version 330 core
+out vec4 FragColor;
+void main() {
+	FragColor = vec4(1.0);
+}
+)";
+static const char* COLOR_FRAGMENT_SHADER = R"(#version 330 core
+in vec4 color;
+out vec4 FragColor;
+void main() {
+	FragColor = color;
+}
+)";
+
+static unsigned int planeProgram = 0;
+static unsigned int modelProgram = 0;
+static unsigned int instancedProgram = 0;
+static unsigned int inverseNormalProgram = 0;
+static unsigned int uniformNormalProgram = 0;
+
+static unsigned int compileShader(GLenum type, const char* source) {
+	unsigned int shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	int success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		char infoLog[512];
+		glGetShaderInfoLog(shader, 512, NULL, infoLog);
+		printf("Failed to compile draw benchmark shader: %s", infoLog);
+	}
+	return shader;
+}
+
+//0 if it doesn't link
+static unsigned int createProgram(const char* vertexSource, const char* fragmentSource) {
+	unsigned int program = glCreateProgram();
+	glAttachShader(program, compileShader(GL_VERTEX_SHADER, vertexSource));
+	glAttachShader(program, compileShader(GL_FRAGMENT_SHADER, fragmentSource));
+	glLinkProgram(program);
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	return success ? program : 0;
+}
+
+//Makes a context current with a TARGET_SIZE framebuffer bound and compiles the programs. False if there is no context to be had
+static bool createDrawContext() {
+	EGLDisplay display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+		return false;
+	const EGLint attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	//Configless and surfaceless, the draws go to a framebuffer object
+	EGLContext context = eglCreateContext(display, (EGLConfig)0, EGL_NO_CONTEXT, attributes);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		return false;
+	if (!gladLoadGL([](const char* name) { return (GLADapiproc)eglGetProcAddress(name); }))
+		return false;
+
+	unsigned int fbo, color;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_SIZE, TARGET_SIZE);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		return false;
+	glViewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+
+	planeProgram = createProgram(PLANE_VERTEX_SHADER, WHITE_FRAGMENT_SHADER);
+	modelProgram = createProgram(MODEL_VERTEX_SHADER, WHITE_FRAGMENT_SHADER);
+	instancedProgram = createProgram(INSTANCED_VERTEX_SHADER, COLOR_FRAGMENT_SHADER);
+	inverseNormalProgram = createProgram(INVERSE_NORMAL_VERTEX_SHADER, NORMAL_FRAGMENT_SHADER);
+	uniformNormalProgram = createProgram(UNIFORM_NORMAL_VERTEX_SHADER, NORMAL_FRAGMENT_SHADER);
+	if (!planeProgram || !modelProgram || !instancedProgram || !inverseNormalProgram || !uniformNormalProgram)
+		return false;
+	printf("Draw benchmarks on %s, GL %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	return true;
+}
+
+//The same plane as generated, reordered by OptimizeMesh, and as strips. Uploaded by the first draw benchmark that runs
+struct DrawPlanes {
+	int subdivisions = 0;
+	bool loaded = false;
+	ew::Mesh generated;
+	ew::Mesh optimized;
+	ew::Mesh strips;
+
+	void load() {
+		if (loaded)
+			return;
+		ew::MeshData plane = ew::createPlane(10.0f, 10.0f, subdivisions);
+		generated.load(plane);
+		ew::MeshData stripData = plane;
+		stripData.indices = ew::StripifyMesh(plane);
+		strips.load(stripData);
+		ew::OptimizeMesh(plane);
+		optimized.load(plane);
+		loaded = true;
+	}
+};
+
+static void addDrawBenchmark(const std::string& name, std::shared_ptr<DrawPlanes> planes, ew::Mesh DrawPlanes::* mesh, ew::DrawMode drawMode) {
+	const int subdivisions = planes->subdivisions;
+	bench::add(name, 2.0 * subdivisions * subdivisions, [planes, mesh, drawMode](uint64_t iterations) {
+		planes->load();
+		glUseProgram(planeProgram);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			((*planes).*mesh).draw(drawMode);
+			//Waits for the draw, so the time is rendering and not queueing
+			glFinish();
+		}
+	});
+}
+
+//A grid of small cubes covering the target, the transforms of a scene with many copies of one mesh
+struct DrawCubes {
+	bool loaded = false;
+	ew::Mesh cube;
+	std::vector<ew::Transform> transforms;
+	ew::InstanceBuffer instances;
+
+	void load() {
+		if (loaded)
+			return;
+		cube.load(ew::createCube(1.0f));
+		const int side = (int)ceilf(sqrtf((float)NUM_CUBES));
+		const float spacing = 2.0f / side;
+		transforms.resize(NUM_CUBES);
+		instances.reserve(NUM_CUBES);
+		for (int i = 0; i < NUM_CUBES; i++)
+		{
+			transforms[i].position = ew::Vec3(-1.0f + spacing * (i % side + 0.5f), -1.0f + spacing * (i / side + 0.5f), 0.0f);
+			transforms[i].rotation = ew::Vec3(30.0f, (float)(i % 360), 0.0f);
+			transforms[i].scale = ew::Vec3(spacing * 0.5f);
+			instances.add(transforms[i], ew::Vec4((float)(i % 7) / 6.0f, 0.5f, 1.0f, 1.0f));
+		}
+		loaded = true;
+	}
+	static const int NUM_CUBES = 100000;
+};
+
+//Objects per second drawing 100k copies of one mesh: a uniform and a draw per object, against one instanced draw.
+//Refilled adds rebuilding the instance list from the transforms and uploading it, as a scene that moves every frame would
+static void registerInstancingBenchmarks() {
+	std::shared_ptr<DrawCubes> cubes = std::make_shared<DrawCubes>();
+	bench::add("draw/cube 100k draw per cube", DrawCubes::NUM_CUBES, [cubes](uint64_t iterations) {
+		cubes->load();
+		glUseProgram(modelProgram);
+		const int modelLocation = glGetUniformLocation(modelProgram, "_Model");
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (const ew::Transform& transform : cubes->transforms)
+			{
+				const ew::Mat4 model = transform.getModelMatrix();
+				glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
+				cubes->cube.draw();
+			}
+			glFinish();
+		}
+	});
+	bench::add("draw/cube 100k instanced", DrawCubes::NUM_CUBES, [cubes](uint64_t iterations) {
+		cubes->load();
+		glUseProgram(instancedProgram);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			cubes->cube.drawInstanced(cubes->instances);
+			glFinish();
+		}
+	});
+	bench::add("draw/cube 100k instanced refilled", DrawCubes::NUM_CUBES, [cubes](uint64_t iterations) {
+		cubes->load();
+		glUseProgram(instancedProgram);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			cubes->instances.clear();
+			for (const ew::Transform& transform : cubes->transforms)
+			{
+				cubes->instances.add(transform);
+			}
+			cubes->cube.drawInstanced(cubes->instances);
+			glFinish();
+		}
+	});
+}
+
+//Small meshes, one per prop, each drawn once as its own ew::Mesh and from one MeshArena
+struct DrawProps {
+	bool loaded = false;
+	std::vector<std::unique_ptr<ew::Mesh>> meshes;
+	std::vector<ew::MeshData> meshData;
+	std::vector<int> arenaIds;
+	std::vector<ew::InstanceData> instances;
+	ew::MeshArena arena;
+
+	void load() {
+		if (loaded)
+			return;
+		const int side = (int)ceilf(sqrtf((float)NUM_PROPS));
+		const float spacing = 2.0f / side;
+		for (int i = 0; i < NUM_PROPS; i++)
+		{
+			//Each prop has its own mesh, as if none of them could be instanced
+			ew::MeshData prop = i % 2 ? ew::createSphere(0.5f, 4 + i % 7) : ew::createCylinder(0.5f, 1.0f, 3 + i % 11);
+			meshes.emplace_back(new ew::Mesh(prop));
+			arenaIds.push_back(arena.add(prop));
+			meshData.push_back(std::move(prop));
+			ew::Transform transform;
+			transform.position = ew::Vec3(-1.0f + spacing * (i % side + 0.5f), -1.0f + spacing * (i / side + 0.5f), 0.0f);
+			transform.rotation = ew::Vec3(30.0f, (float)(i % 360), 0.0f);
+			transform.scale = ew::Vec3(spacing * 0.8f);
+			instances.push_back({ transform.getModelMatrix(), ew::Vec4(1.0f) });
+		}
+		loaded = true;
+	}
+	static const int NUM_PROPS = 1000;
+};
+
+//Meshes per second drawing 1000 meshes: a VAO bind, uniform and draw each, against one multi-draw-indirect from a MeshArena.
+//Churn removes and adds back a tenth of the arena's meshes, defragment compacts after removing and adding back half of them
+static void registerArenaBenchmarks() {
+	std::shared_ptr<DrawProps> props = std::make_shared<DrawProps>();
+	bench::add("draw/props 1000 Mesh::draw each", DrawProps::NUM_PROPS, [props](uint64_t iterations) {
+		props->load();
+		glUseProgram(modelProgram);
+		const int modelLocation = glGetUniformLocation(modelProgram, "_Model");
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (int i = 0; i < DrawProps::NUM_PROPS; i++)
+			{
+				glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &props->instances[i].model[0][0]);
+				props->meshes[i]->draw();
+			}
+			glFinish();
+		}
+	});
+	bench::add("draw/props 1000 MeshArena::drawQueued", DrawProps::NUM_PROPS, [props](uint64_t iterations) {
+		props->load();
+		glUseProgram(instancedProgram);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (int i = 0; i < DrawProps::NUM_PROPS; i++)
+			{
+				props->arena.queue(props->arenaIds[i], props->instances[i]);
+			}
+			props->arena.drawQueued();
+			glFinish();
+		}
+	});
+	bench::add("draw/props 1000 MeshArena churn 100", 100, [props](uint64_t iterations) {
+		props->load();
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			//Pairs of meshes of different sizes removed and added back in the other order, so holes open up and get refilled
+			for (int i = 0; i < 50; i++)
+			{
+				const int a = (int)((it * 50 + i) * 7 % DrawProps::NUM_PROPS);
+				const int b = (a + DrawProps::NUM_PROPS / 2 + 1) % DrawProps::NUM_PROPS;
+				props->arena.remove(props->arenaIds[a]);
+				props->arena.remove(props->arenaIds[b]);
+				props->arenaIds[b] = props->arena.add(props->meshData[b]);
+				props->arenaIds[a] = props->arena.add(props->meshData[a]);
+			}
+			glFinish();
+		}
+	});
+	bench::add("draw/props 1000 MeshArena defragment", DrawProps::NUM_PROPS, [props](uint64_t iterations) {
+		props->load();
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			//Every other mesh removed and added again, leaving a hole per mesh
+			for (int i = 0; i < DrawProps::NUM_PROPS; i += 2)
+			{
+				props->arena.remove(props->arenaIds[i]);
+				props->arenaIds[i] = props->arena.add(props->meshData[i]);
+			}
+			props->arena.defragment();
+			glFinish();
+		}
+	});
+}
+
+//Triangles per second drawing a plane as triangle lists and as strips with primitive restart.
+//200 subdivisions has 16-bit indices, 400 has 32-bit ones
+static void registerStripBenchmarks() {
+	for (int subdivisions : { 200, 400 })
+	{
+		std::shared_ptr<DrawPlanes> planes = std::make_shared<DrawPlanes>();
+		planes->subdivisions = subdivisions;
+		const std::string prefix = "draw/plane " + std::to_string(subdivisions);
+		addDrawBenchmark(prefix + " triangles", planes, &DrawPlanes::generated, ew::DrawMode::TRIANGLES);
+		addDrawBenchmark(prefix + " triangles optimized", planes, &DrawPlanes::optimized, ew::DrawMode::TRIANGLES);
+		addDrawBenchmark(prefix + " strips", planes, &DrawPlanes::strips, ew::DrawMode::TRIANGLE_STRIP);
+	}
+}
+
+//Vertices per second drawing a 401x401 vertex plane with the normal matrix inverted per vertex and uploaded as a uniform.
+//Culled draws only run the vertex stage, so they show the shader difference without the fill cost
+static void registerNormalMatrixBenchmarks() {
+	std::shared_ptr<DrawPlanes> planes = std::make_shared<DrawPlanes>();
+	planes->subdivisions = 400;
+	const double numVertices = 401.0 * 401.0;
+	for (bool culled : { false, true })
+	{
+		for (bool perVertex : { true, false })
+		{
+			const std::string name = std::string("draw/plane 400 normal matrix ") + (perVertex ? "per vertex" : "uniform") + (culled ? " culled" : "");
+			bench::add(name, numVertices, [planes, culled, perVertex](uint64_t iterations) {
+				planes->load();
+				const unsigned int program = perVertex ? inverseNormalProgram : uniformNormalProgram;
+				glUseProgram(program);
+				//Non uniform scale, so the normal matrix isn't just the rotation
+				const ew::Mat4 model = ew::RotateX(ew::Radians(-80.0f)) * ew::Scale(ew::Vec3(0.19f, 0.5f, 0.15f));
+				const ew::Mat3 normalMatrix = ew::NormalMatrix(model);
+				glUniformMatrix4fv(glGetUniformLocation(program, "_Model"), 1, GL_FALSE, &model[0][0]);
+				if (!perVertex)
+					glUniformMatrix3fv(glGetUniformLocation(program, "_NormalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
+				if (culled) {
+					glEnable(GL_CULL_FACE);
+					glCullFace(GL_FRONT_AND_BACK);
+				}
+				for (uint64_t it = 0; it < iterations; it++)
+				{
+					planes->generated.draw();
+					glFinish();
+				}
+				glDisable(GL_CULL_FACE);
+				glCullFace(GL_BACK);
+			});
+		}
+	}
+}
+
+//How a 401x401 land's vertices get replaced: a static reload with glBufferData, or updateVertices on a dynamic ring
+//written with glBufferSubData or through a persistent mapping (GL 4.4)
+enum class UploadPath { STATIC, SUB_DATA, PERSISTENT, COUNT };
+
+//Two 401x401 lands of different seeds, uploaded in turn as a reseeded land would be. One mesh per format and path
+struct UploadLands {
+	bool loaded = false;
+	ew::MeshData lands[2];
+	ew::AABB bounds[2];
+	ew::VertexFormat formats[2];
+	ew::Mesh meshes[2][(int)UploadPath::COUNT];
+
+	UploadLands() {
+		formats[1] = { ew::PositionFormat::UNORM16, ew::NormalFormat::OCT16, ew::UVFormat::UNORM16 };
+	}
+	void load() {
+		if (loaded)
+			return;
+		for (int i = 0; i < 2; i++)
+		{
+			lands[i] = wm::createLand(40.0f, 400, 300 + i);
+			bounds[i] = ew::CalculateBounds(lands[i]);
+		}
+		for (int f = 0; f < 2; f++)
+		{
+			meshes[f][(int)UploadPath::STATIC].load(lands[0].vertices.data(), (int)lands[0].vertices.size(), lands[0].indices.data(), (int)lands[0].indices.size(), bounds[0], formats[f]);
+			//The ring takes the glBufferSubData path without GL 4.4, pretend it isn't there for that one
+			const int hasGL44 = GLAD_GL_VERSION_4_4;
+			GLAD_GL_VERSION_4_4 = 0;
+			meshes[f][(int)UploadPath::SUB_DATA].loadDynamic(lands[0], formats[f]);
+			GLAD_GL_VERSION_4_4 = hasGL44;
+			meshes[f][(int)UploadPath::PERSISTENT].loadDynamic(lands[0], formats[f]);
+		}
+		loaded = true;
+	}
+};
+
+//Vertices per second replacing every vertex of a 401x401 land and drawing it, in the default and in Final_Project's compact format.
+//The draws are culled, so the time is the upload and the vertex stage reading it
+static void registerUploadBenchmarks() {
+	std::shared_ptr<UploadLands> uploads = std::make_shared<UploadLands>();
+	const double numVertices = 401.0 * 401.0;
+	const char* formatNames[2] = { "float", "compact" };
+	const char* pathNames[(int)UploadPath::COUNT] = { "static glBufferData", "dynamic glBufferSubData", "dynamic persistent ring" };
+	for (int f = 0; f < 2; f++)
+	{
+		for (int path = 0; path < (int)UploadPath::COUNT; path++)
+		{
+			if (path == (int)UploadPath::PERSISTENT && !GLAD_GL_VERSION_4_4)
+				continue;
+			bench::add(std::string("draw/upload 401x401 ") + formatNames[f] + " " + pathNames[path], numVertices, [uploads, f, path](uint64_t iterations) {
+				uploads->load();
+				ew::Mesh& mesh = uploads->meshes[f][path];
+				glUseProgram(planeProgram);
+				glEnable(GL_CULL_FACE);
+				glCullFace(GL_FRONT_AND_BACK);
+				for (uint64_t it = 0; it < iterations; it++)
+				{
+					const int i = (int)(it % 2);
+					const ew::MeshData& land = uploads->lands[i];
+					if (path == (int)UploadPath::STATIC)
+						mesh.load(land.vertices.data(), (int)land.vertices.size(), land.indices.data(), (int)land.indices.size(), uploads->bounds[i], uploads->formats[f]);
+					else
+						mesh.updateVertices(0, land.vertices.data(), (int)land.vertices.size());
+					mesh.draw();
+					glFinish();
+				}
+				glDisable(GL_CULL_FACE);
+				glCullFace(GL_BACK);
+			});
+		}
+	}
+}
+
+void registerDrawBenchmarks() {
+	if (!createDrawContext()) {
+		printf("No EGL context, draw benchmarks skipped\n");
+		return;
+	}
+	registerStripBenchmarks();
+	registerInstancingBenchmarks();
+	registerArenaBenchmarks();
+	registerNormalMatrixBenchmarks();
+	registerUploadBenchmarks();
+}
+#else
+void registerDrawBenchmarks() {
+}
+#endif
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "bench.h"
+
+void registerMathBenchmarks();
+void registerProcGenBenchmarks();
+void registerDrawBenchmarks();
+void printNoiseStatistics();
+void printVertexCacheStatistics();
+int verifySimd();
+
+//--verify checks the ewMath SIMD paths against scalar code instead of running benchmarks
+//Usage: core_bench [--filter <substring>] [--json <path>] [--min-time <ms>] [--noise-stats] [--cache-stats] [--verify]
+int main(int argc, char** argv) {
+	std::string filter;
+	std::string jsonPath;
+	double minTimeMs = 50.0;
+	bool noiseStats = false;
+	bool cacheStats = false;
+	bool verify = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			minTimeMs = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--noise-stats") == 0) {
+			noiseStats = true;
+		}
+		else if (strcmp(argv[i], "--cache-stats") == 0) {
+			cacheStats = true;
+		}
+		else if (strcmp(argv[i], "--verify") == 0) {
+			verify = true;
+		}
+		else {
+			printf("Usage: %s [--filter <substring>] [--json <path>] [--min-time <ms>] [--noise-stats] [--cache-stats] [--verify]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (verify) {
+		return verifySimd();
+	}
+
+	registerMathBenchmarks();
+	registerProcGenBenchmarks();
+	registerDrawBenchmarks();
+
+	std::vector<bench::Result> results = bench::runAll(filter, minTimeMs);
+	bench::printTable(results);
+	if (noiseStats) {
+		printf("\n");
+		printNoiseStatistics();
+	}
+	if (cacheStats) {
+		printf("\n");
+		printVertexCacheStatistics();
+	}
+	if (!jsonPath.empty() && !bench::writeJson(results, jsonPath)) {
+		return 1;
+	}
+	return 0;
+}
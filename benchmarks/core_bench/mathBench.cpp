@@ -0,0 +1,254 @@
+#include <vector>
+#include <stdlib.h>
+
+#include "bench.h"
+#include <ew/ewMath/ewMath.h>
+#include <ew/ewMath/transformations.h>
+#include <ew/ewMath/batch.h>
+#include <ew/ewMath/frustum.h>
+#include <ew/transform.h>
+#include <ew/transformHierarchy.h>
+#include <ew/threadPool.h>
+
+static float randomRange(float min, float max) {
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static ew::Mat4 randomTRS() {
+	return ew::TRS(ew::Vec3(randomRange(-10, 10), randomRange(-10, 10), randomRange(-10, 10)),
+		ew::Vec3(randomRange(0, 6.28f), randomRange(0, 6.28f), randomRange(0, 6.28f)),
+		ew::Vec3(randomRange(0.5f, 2.0f), randomRange(0.5f, 2.0f), randomRange(0.5f, 2.0f)));
+}
+
+static void registerMatrixBenchmarks() {
+	const size_t COUNT = 1024;
+	static std::vector<ew::Mat4> matrices;
+	static std::vector<ew::Vec4> vectors;
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		matrices.push_back(randomTRS());
+		vectors.push_back(ew::Vec4(randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1), 1.0f));
+	}
+
+	bench::add("ewMath/Mat4*Mat4", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::Mat4 accum = ew::IdentityMatrix();
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				accum = matrices[i] * accum;
+			}
+			bench::doNotOptimize(accum);
+		}
+	});
+	bench::add("ewMath/Mat4*Vec4", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::Vec4 sum(0.0f);
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				ew::Vec4 v = matrices[i] * vectors[i];
+				sum.x += v.x; sum.y += v.y; sum.z += v.z; sum.w += v.w;
+			}
+			bench::doNotOptimize(sum);
+		}
+	});
+	bench::add("ewMath/Inverse", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				ew::Mat4 inv = ew::Inverse(matrices[i]);
+				bench::doNotOptimize(inv);
+			}
+		}
+	});
+	bench::add("ewMath/NormalMatrix", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				ew::Mat3 n = ew::NormalMatrix(matrices[i]);
+				bench::doNotOptimize(n);
+			}
+		}
+	});
+}
+
+static void registerTransformBenchmarks() {
+	static ew::Vec3 t(1.0f, 2.0f, 3.0f), r(0.3f, 0.7f, 1.1f), s(1.0f, 2.0f, 0.5f);
+	bench::add("transform/TRS", 1, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			bench::doNotOptimize(t);
+			ew::Mat4 m = ew::TRS(t, r, s);
+			bench::doNotOptimize(m);
+		}
+	});
+	bench::add("transform/T*Ry*Rx*Rz*S", 1, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			bench::doNotOptimize(t);
+			ew::Mat4 m = ew::Translate(t) * ew::RotateY(r.y) * ew::RotateX(r.x) * ew::RotateZ(r.z) * ew::Scale(s);
+			bench::doNotOptimize(m);
+		}
+	});
+	bench::add("transform/Transform::getModelMatrix cached", 1, [](uint64_t iterations) {
+		ew::Transform transform;
+		transform.position = t;
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::Mat4 m = transform.getModelMatrix();
+			bench::doNotOptimize(m);
+		}
+	});
+	bench::add("transform/Transform::getModelMatrix changed", 1, [](uint64_t iterations) {
+		ew::Transform transform;
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			transform.rotation.y = (float)(it & 255);
+			ew::Mat4 m = transform.getModelMatrix();
+			bench::doNotOptimize(m);
+		}
+	});
+}
+
+static void registerBatchBenchmarks() {
+	const size_t COUNT = 4096;
+	static std::vector<ew::Vec3> points;
+	static std::vector<ew::Vec3> out(COUNT);
+	static std::vector<float> xs, ys, zs, ox(COUNT), oy(COUNT), oz(COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		ew::Vec3 p(randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1));
+		points.push_back(p);
+		xs.push_back(p.x);
+		ys.push_back(p.y);
+		zs.push_back(p.z);
+	}
+	static ew::Mat4 m = randomTRS();
+
+	bench::add("batch/Mat4*Vec4 loop", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				out[i] = (m * ew::Vec4(points[i], 1.0f)).toVec3();
+			}
+			bench::doNotOptimize(out.data());
+		}
+	});
+	bench::add("batch/TransformPoints", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::TransformPoints(m, points.data(), out.data(), COUNT);
+			bench::doNotOptimize(out.data());
+		}
+	});
+	bench::add("batch/TransformSoA", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::TransformSoA(m, xs.data(), ys.data(), zs.data(), ox.data(), oy.data(), oz.data(), COUNT);
+			bench::doNotOptimize(ox.data());
+		}
+	});
+}
+
+static void registerCullingBenchmarks() {
+	const size_t COUNT = 4096;
+	static std::vector<float> x, y, z, radius, ex, ey, ez;
+	static std::vector<uint8_t> visible(COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		x.push_back(randomRange(-100, 100));
+		y.push_back(randomRange(-100, 100));
+		z.push_back(randomRange(-100, 100));
+		radius.push_back(randomRange(0.5f, 5.0f));
+		ex.push_back(randomRange(0.5f, 5.0f));
+		ey.push_back(randomRange(0.5f, 5.0f));
+		ez.push_back(randomRange(0.5f, 5.0f));
+	}
+	static ew::Frustum frustum = ew::ExtractFrustum(
+		ew::Perspective(ew::Radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * ew::LookAt(ew::Vec3(0, 0, 5), ew::Vec3(0), ew::Vec3(0, 1, 0)));
+
+	bench::add("culling/IsVisible(sphere) loop", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			size_t numVisible = 0;
+			for (size_t i = 0; i < COUNT; i++)
+			{
+				numVisible += ew::IsVisible(frustum, ew::BoundingSphere{ ew::Vec3(x[i], y[i], z[i]), radius[i] });
+			}
+			bench::doNotOptimize(numVisible);
+		}
+	});
+	bench::add("culling/CullSpheres", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			size_t numVisible = ew::CullSpheres(frustum, x.data(), y.data(), z.data(), radius.data(), COUNT, visible.data());
+			bench::doNotOptimize(numVisible);
+		}
+	});
+	bench::add("culling/CullAABBs", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			size_t numVisible = ew::CullAABBs(frustum, x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), COUNT, visible.data());
+			bench::doNotOptimize(numVisible);
+		}
+	});
+}
+
+static void registerHierarchyBenchmarks() {
+	const int COUNT = 100000;
+	static ew::TransformHierarchy hierarchy;
+	hierarchy.reserve(COUNT);
+	//Wide, shallow scene: roots with chains of children
+	for (int i = 0; i < COUNT; i++)
+	{
+		int parent = (i % 10 == 0) ? ew::TransformHierarchy::NO_PARENT : i - 1;
+		hierarchy.add(parent, ew::Vec3(randomRange(-1, 1), 0, 0), ew::Vec3(0, randomRange(0, 360), 0));
+	}
+	hierarchy.update();
+
+	bench::add("hierarchy/update 100k 1% dirty", COUNT / 100, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (int i = 0; i < COUNT; i += 100)
+			{
+				hierarchy.setRotation(i, ew::Vec3(0, (float)(it & 255), 0));
+			}
+			hierarchy.update();
+		}
+	});
+	bench::add("hierarchy/update 100k all dirty", COUNT, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (int i = 0; i < COUNT; i += 10)
+			{
+				hierarchy.setRotation(i, ew::Vec3(0, (float)(it & 255), 0));
+			}
+			hierarchy.update();
+		}
+	});
+	bench::add("hierarchy/update 100k all dirty pool", COUNT, [](uint64_t iterations) {
+		//Every hardware thread, reused across updates as a frame loop would
+		static ew::ThreadPool pool;
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			for (int i = 0; i < COUNT; i += 10)
+			{
+				hierarchy.setRotation(i, ew::Vec3(0, (float)(it & 255), 0));
+			}
+			hierarchy.update(&pool);
+		}
+	});
+}
+
+void registerMathBenchmarks() {
+	srand(1234);
+	registerMatrixBenchmarks();
+	registerTransformBenchmarks();
+	registerBatchBenchmarks();
+	registerCullingBenchmarks();
+	registerHierarchyBenchmarks();
+}
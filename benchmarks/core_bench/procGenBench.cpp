@@ -0,0 +1,418 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include <ew/procGen.h>
+#include <ew/meshOptimize.h>
+#include <wm/procGen.h>
+#include <wm/perlinNoise.h>
+#include <wm/simplexNoise.h>
+#include <wm/landCache.h>
+#include <ew/threadPool.h>
+#include <thread>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+static void registerNoiseBenchmarks() {
+	const int SIZE = 256;
+	bench::add("noise/PerlinNoise::noiseGen legacy hash 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::PerlinNoise perlin(0, ir::PerlinNoise::Mode::LEGACY_HASH);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			float sum = 0.0f;
+			for (int y = 0; y < SIZE; y++)
+			{
+				for (int x = 0; x < SIZE; x++)
+				{
+					sum += perlin.noiseGen(x * 0.05f, y * 0.05f, 0);
+				}
+			}
+			bench::doNotOptimize(sum);
+		}
+	});
+	bench::add("noise/PerlinNoise::noiseGen table 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::PerlinNoise perlin(0);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			float sum = 0.0f;
+			for (int y = 0; y < SIZE; y++)
+			{
+				for (int x = 0; x < SIZE; x++)
+				{
+					sum += perlin.noiseGen(x * 0.05f, y * 0.05f, 0);
+				}
+			}
+			bench::doNotOptimize(sum);
+		}
+	});
+	bench::add("noise/PerlinNoise::noiseGrid 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::PerlinNoise perlin(0);
+		std::vector<float> heights(SIZE * SIZE);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			perlin.noiseGrid(heights.data(), SIZE, SIZE, 0.0f, 0.0f, 0.05f, 0.05f, 0);
+			bench::doNotOptimize(heights.data());
+		}
+	});
+	bench::add("noise/SimplexNoise::noise2D 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::SimplexNoise simplex(0);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			float sum = 0.0f;
+			for (int y = 0; y < SIZE; y++)
+			{
+				for (int x = 0; x < SIZE; x++)
+				{
+					sum += simplex.noise2D(x * 0.05f, y * 0.05f);
+				}
+			}
+			bench::doNotOptimize(sum);
+		}
+	});
+	bench::add("noise/SimplexNoise::noiseRegion 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::SimplexNoise simplex(0);
+		std::vector<float> heights(SIZE * SIZE);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			simplex.noiseRegion(heights.data(), SIZE, 0, SIZE, 0, SIZE, 0.0f, 0.0f, 0.05f, 0.05f);
+			bench::doNotOptimize(heights.data());
+		}
+	});
+	bench::add("noise/PerlinNoise::noiseRegionDerivatives 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::PerlinNoise perlin(0);
+		std::vector<float> heights(SIZE * SIZE), ddx(SIZE * SIZE), ddy(SIZE * SIZE);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			perlin.noiseRegionDerivatives(heights.data(), ddx.data(), ddy.data(), SIZE, 0, SIZE, 0, SIZE, 0.0f, 0.0f, 0.05f, 0.05f, 0);
+			bench::doNotOptimize(heights.data());
+		}
+	});
+	bench::add("noise/SimplexNoise::noiseRegionDerivatives 256x256", SIZE * SIZE, [](uint64_t iterations) {
+		ir::SimplexNoise simplex(0);
+		std::vector<float> heights(SIZE * SIZE), ddx(SIZE * SIZE), ddy(SIZE * SIZE);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			simplex.noiseRegionDerivatives(heights.data(), ddx.data(), ddy.data(), SIZE, 0, SIZE, 0, SIZE, 0.0f, 0.0f, 0.05f, 0.05f);
+			bench::doNotOptimize(heights.data());
+		}
+	});
+
+	const int SIZE_3D = 40;
+	bench::add("noise/PerlinNoise::noiseGen3D 40^3", SIZE_3D * SIZE_3D * SIZE_3D, [](uint64_t iterations) {
+		ir::PerlinNoise perlin(0);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			float sum = 0.0f;
+			for (int z = 0; z < SIZE_3D; z++)
+				for (int y = 0; y < SIZE_3D; y++)
+					for (int x = 0; x < SIZE_3D; x++)
+						sum += perlin.noiseGen3D(x * 0.05f, y * 0.05f, z * 0.05f);
+			bench::doNotOptimize(sum);
+		}
+	});
+	bench::add("noise/SimplexNoise::noise3D 40^3", SIZE_3D * SIZE_3D * SIZE_3D, [](uint64_t iterations) {
+		ir::SimplexNoise simplex(0);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			float sum = 0.0f;
+			for (int z = 0; z < SIZE_3D; z++)
+				for (int y = 0; y < SIZE_3D; y++)
+					for (int x = 0; x < SIZE_3D; x++)
+						sum += simplex.noise3D(x * 0.05f, y * 0.05f, z * 0.05f);
+			bench::doNotOptimize(sum);
+		}
+	});
+}
+
+//Range, mean and standard deviation of one noise function over many samples
+struct NoiseStatistics {
+	float min = 1e30f, max = -1e30f;
+	double sum = 0.0, sumSquares = 0.0;
+	uint64_t count = 0;
+
+	void add(float value) {
+		min = value < min ? value : min;
+		max = value > max ? value : max;
+		sum += value;
+		sumSquares += (double)value * value;
+		count++;
+	}
+	void print(const char* name) const {
+		double mean = sum / count;
+		printf("%-20s %10.4f %10.4f %10.4f %10.4f\n", name, min, max, mean, sqrt(sumSquares / count - mean * mean));
+	}
+};
+
+//Visual statistics of each noise backend, to pick one per use case next to the timings. Same seeds and sample spacing for both
+void printNoiseStatistics() {
+	const int SEEDS = 8;
+	const int SIZE = 512;
+	const int SIZE_3D = 64;
+	const float STEP = 0.037f; //not a fraction of the lattice, so samples don't line up with lattice points (always 0)
+	NoiseStatistics perlin2D, simplex2D, perlin3D, simplex3D;
+	std::vector<float> heights(SIZE * SIZE);
+	for (int seed = 0; seed < SEEDS; seed++)
+	{
+		ir::PerlinNoise perlin(seed);
+		ir::SimplexNoise simplex(seed);
+		ir::Noise* backends[2] = { &perlin, &simplex };
+		NoiseStatistics* stats2D[2] = { &perlin2D, &simplex2D };
+		NoiseStatistics* stats3D[2] = { &perlin3D, &simplex3D };
+		for (int b = 0; b < 2; b++)
+		{
+			backends[b]->noiseRegion(heights.data(), SIZE, 0, SIZE, 0, SIZE, 0.0f, 0.0f, STEP, STEP);
+			for (float h : heights)
+			{
+				stats2D[b]->add(h);
+			}
+			for (int z = 0; z < SIZE_3D; z++)
+				for (int y = 0; y < SIZE_3D; y++)
+					for (int x = 0; x < SIZE_3D; x++)
+						stats3D[b]->add(backends[b]->noise3D(x * STEP, y * STEP, z * STEP));
+		}
+	}
+	printf("%-20s %10s %10s %10s %10s\n", "noise", "min", "max", "mean", "stddev");
+	perlin2D.print("PerlinNoise 2D");
+	simplex2D.print("SimplexNoise 2D");
+	perlin3D.print("PerlinNoise 3D");
+	simplex3D.print("SimplexNoise 3D");
+}
+
+//1, 2, 4... up to the hardware thread count
+static std::vector<unsigned int> threadCounts() {
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	maxThreads = maxThreads == 0 ? 1 : maxThreads;
+	std::vector<unsigned int> counts;
+	for (unsigned int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		counts.push_back(numThreads);
+	}
+	counts.push_back(maxThreads);
+	return counts;
+}
+
+//Heightfield throughput (samples/s) against thread count
+static void registerFractalBenchmarks() {
+	const int SIZE = 512;
+	for (unsigned int numThreads : threadCounts())
+	{
+		bench::add("noise/fractalGrid fBm 6 octaves 512x512 threads:" + std::to_string(numThreads), SIZE * SIZE, [numThreads](uint64_t iterations) {
+			ew::ThreadPool pool(numThreads);
+			ir::PerlinNoise perlin(0);
+			ir::FractalSettings settings;
+			std::vector<float> heights(SIZE * SIZE);
+			for (uint64_t it = 0; it < iterations; it++)
+			{
+				perlin.fractalGrid(heights.data(), SIZE, SIZE, 0.0f, 0.0f, 0.01f, 0.01f, settings, &pool);
+				bench::doNotOptimize(heights.data());
+			}
+		});
+	}
+}
+
+static void addMeshBenchmark(const std::string& name, double numVertices, ew::MeshData(*generate)(int), int subdivisions) {
+	bench::add(name + "/" + std::to_string(subdivisions), numVertices, [generate, subdivisions](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::MeshData mesh = generate(subdivisions);
+			bench::doNotOptimize(mesh.vertices.data());
+		}
+	});
+}
+
+static void registerMeshBenchmarks() {
+	const int SUBDIVISIONS[] = { 16, 64, 256 };
+	bench::add("procGen/ew::createCube", 24, [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::MeshData mesh = ew::createCube(1.0f);
+			bench::doNotOptimize(mesh.vertices.data());
+		}
+	});
+	for (int n : SUBDIVISIONS)
+	{
+		double grid = (double)(n + 1) * (n + 1);
+		addMeshBenchmark("procGen/ew::createPlane", grid, [](int s) { return ew::createPlane(1.0f, 1.0f, s); }, n);
+		addMeshBenchmark("procGen/ew::createSphere", grid, [](int s) { return ew::createSphere(1.0f, s); }, n);
+		addMeshBenchmark("procGen/ew::createCylinder", n * 4.0 + 2.0, [](int s) { return ew::createCylinder(1.0f, 1.0f, s); }, n);
+		addMeshBenchmark("procGen/wm::createPlane", grid, [](int s) { return wm::createPlane(1.0f, s); }, n);
+		addMeshBenchmark("procGen/wm::createSphere", grid, [](int s) { return wm::createSphere(1.0f, s); }, n);
+		addMeshBenchmark("procGen/wm::createCylinder", n * 4.0 + 2.0, [](int s) { return wm::createCylinder(1.0f, 1.0f, s); }, n);
+		addMeshBenchmark("procGen/wm::createTorus", grid, [](int s) { return wm::createTorus(0.5f, 1.0f, s, s); }, n);
+		addMeshBenchmark("procGen/wm::createLand", grid, [](int s) { return wm::createLand(40.0f, s, 0); }, n);
+	}
+	//Final_Project's land
+	addMeshBenchmark("procGen/wm::createLand legacy hash", 401.0 * 401.0, [](int s) {
+		wm::LandSettings settings;
+		settings.noiseMode = ir::PerlinNoise::Mode::LEGACY_HASH;
+		return wm::createLand(40.0f, s, 0, settings);
+	}, 400);
+	addMeshBenchmark("procGen/wm::createLand finite difference normals", 401.0 * 401.0, [](int s) {
+		wm::LandSettings settings;
+		settings.normals = wm::LandNormals::FINITE_DIFFERENCES;
+		return wm::createLand(40.0f, s, 0, settings);
+	}, 400);
+	addMeshBenchmark("procGen/wm::createLand", 401.0 * 401.0, [](int s) { return wm::createLand(40.0f, s, 0); }, 400);
+	addMeshBenchmark("procGen/wm::createLand simplex", 401.0 * 401.0, [](int s) {
+		wm::LandSettings settings;
+		settings.noise = ir::NoiseType::SIMPLEX;
+		return wm::createLand(40.0f, s, 0, settings);
+	}, 400);
+	for (unsigned int numThreads : threadCounts())
+	{
+		bench::add("procGen/wm::createLand/400 threads:" + std::to_string(numThreads), 401.0 * 401.0, [numThreads](uint64_t iterations) {
+			ew::ThreadPool pool(numThreads);
+			for (uint64_t it = 0; it < iterations; it++)
+			{
+				ew::MeshData mesh = wm::createLand(40.0f, 400, 0, wm::LandSettings(), &pool);
+				bench::doNotOptimize(mesh.vertices.data());
+			}
+		});
+	}
+}
+
+//An unindexed import: every triangle of the 401x401 land with its own 3 vertices. Built on first use
+static const ew::MeshData& landSoup() {
+	static const ew::MeshData soup = [] {
+		const ew::MeshData grid = wm::createLand(40.0f, 400, 0);
+		ew::MeshData unindexed;
+		for (unsigned int index : grid.indices)
+		{
+			unindexed.indices.push_back((unsigned int)unindexed.vertices.size());
+			unindexed.vertices.push_back(grid.vertices[index]);
+		}
+		return unindexed;
+	}();
+	return soup;
+}
+
+static void registerPostProcessBenchmarks() {
+	static ew::MeshData land = wm::createLand(40.0f, 256, 0);
+	bench::add("meshData/CalculateBounds land 256", (double)land.vertices.size(), [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::AABB bounds = ew::CalculateBounds(land);
+			bench::doNotOptimize(bounds);
+		}
+	});
+	//32 to 16 bytes per vertex, what a compact upload costs on top of createLand
+	bench::add("meshData/PackMeshData land 256 compact", (double)land.vertices.size(), [](uint64_t iterations) {
+		const ew::VertexFormat compact = { ew::PositionFormat::UNORM16, ew::NormalFormat::OCT16, ew::UVFormat::UNORM16 };
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::PackedMeshData packed = ew::PackMeshData(land, compact);
+			bench::doNotOptimize(packed.vertices.data());
+		}
+	});
+	for (unsigned int numThreads : threadCounts())
+	{
+		bench::add("meshData/WeldVertices exact soup 400 threads:" + std::to_string(numThreads), 400.0 * 400.0 * 6.0, [numThreads](uint64_t iterations) {
+			ew::ThreadPool pool(numThreads);
+			for (uint64_t it = 0; it < iterations; it++)
+			{
+				ew::MeshData welded = landSoup();
+				ew::WeldReport report = ew::WeldVertices(welded, ew::WeldSettings(), &pool);
+				bench::doNotOptimize(report);
+			}
+		});
+	}
+	bench::add("meshData/WeldVertices epsilon soup 400", 400.0 * 400.0 * 6.0, [](uint64_t iterations) {
+		ew::WeldSettings settings;
+		settings.mode = ew::WeldMode::EPSILON;
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::MeshData welded = landSoup();
+			ew::WeldReport report = ew::WeldVertices(welded, settings);
+			bench::doNotOptimize(report);
+		}
+	});
+	//Triangles per second, the one time cost of reordering a generated mesh
+	static ew::MeshData sphere = ew::createSphere(1.0f, 64);
+	bench::add("meshData/OptimizeMesh sphere 64", (double)(sphere.indices.size() / 3), [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			ew::MeshData optimized = sphere;
+			ew::MeshOptimizeReport report = ew::OptimizeMesh(optimized);
+			bench::doNotOptimize(report);
+		}
+	});
+	static ew::MeshData plane = ew::createPlane(10.0f, 10.0f, 400);
+	bench::add("meshData/StripifyMesh plane 400", (double)(plane.indices.size() / 3), [](uint64_t iterations) {
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			std::vector<unsigned int> strips = ew::StripifyMesh(plane);
+			bench::doNotOptimize(strips.data());
+		}
+	});
+}
+
+//Duplicate vertices of every generator, ACMR/ATVR before and after OptimizeMesh simulated with a 16 entry cache, and index counts as strips
+void printVertexCacheStatistics() {
+	struct Generated {
+		const char* name;
+		ew::MeshData meshData;
+	};
+	std::vector<Generated> meshes;
+	meshes.push_back({ "ew::createCube", ew::createCube(1.0f) });
+	meshes.push_back({ "ew::createPlane 64", ew::createPlane(1.0f, 1.0f, 64) });
+	meshes.push_back({ "ew::createSphere 64", ew::createSphere(1.0f, 64) });
+	meshes.push_back({ "ew::createCylinder 64", ew::createCylinder(1.0f, 1.0f, 64) });
+	meshes.push_back({ "wm::createSphere 64", wm::createSphere(1.0f, 64) });
+	meshes.push_back({ "wm::createCylinder 64", wm::createCylinder(1.0f, 1.0f, 64) });
+	meshes.push_back({ "wm::createTorus 64x64", wm::createTorus(0.5f, 1.0f, 64, 64) });
+	meshes.push_back({ "wm::createLand 100", wm::createLand(10.0f, 100, 0) });
+	//Seam and cap vertices share positions but not normals or UVs, so only position welding finds them
+	ew::WeldSettings positionOnly;
+	positionOnly.compareNormals = false;
+	positionOnly.compareUVs = false;
+	printf("%-24s %10s %10s %10s\n", "mesh", "vertices", "welded", "positions");
+	for (Generated& mesh : meshes)
+	{
+		ew::MeshData welded = mesh.meshData;
+		ew::MeshData weldedPositions = mesh.meshData;
+		ew::WeldReport report = ew::WeldVertices(welded);
+		ew::WeldVertices(weldedPositions, positionOnly);
+		printf("%-24s %10d %10d %10d\n", mesh.name, report.verticesBefore, report.verticesAfter, (int)weldedPositions.vertices.size());
+	}
+	printf("\n%-24s %10s %10s %10s %10s\n", "mesh", "ACMR", "optimized", "ATVR", "optimized");
+	for (Generated& mesh : meshes)
+	{
+		ew::MeshOptimizeReport report = ew::OptimizeMesh(mesh.meshData, 16);
+		printf("%-24s %10.3f %10.3f %10.3f %10.3f\n", mesh.name, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+	}
+	printf("\n%-24s %10s %10s %10s %10s\n", "mesh", "indices", "strips", "restarts", "ratio");
+	for (Generated& mesh : meshes)
+	{
+		std::vector<unsigned int> strips = ew::StripifyMesh(mesh.meshData);
+		const int restarts = (int)std::count(strips.begin(), strips.end(), ew::PRIMITIVE_RESTART_INDEX);
+		printf("%-24s %10d %10d %10d %10.3f\n", mesh.name, (int)mesh.meshData.indices.size(), (int)strips.size(), restarts, (double)strips.size() / mesh.meshData.indices.size());
+	}
+}
+
+//A revisited seed: map the cache file written by the first get and read every vertex, as an upload would
+static void registerLandCacheBenchmarks() {
+	bench::add("landCache/LandCache::find disk hit 400", 401.0 * 401.0, [](uint64_t iterations) {
+		const wm::LandCacheKey key = { 40.0f, 400, 0, wm::LandSettings() };
+		wm::LandCache(std::string("core_bench_landCache")).get(key);
+		for (uint64_t it = 0; it < iterations; it++)
+		{
+			wm::LandCache cache("core_bench_landCache", 0);
+			std::shared_ptr<const wm::CachedLand> land = cache.find(key);
+			float sum = 0.0f;
+			for (int i = 0; i < land->getNumVertices(); i++)
+			{
+				sum += land->getVertices()[i].pos.y;
+			}
+			bench::doNotOptimize(sum);
+		}
+	});
+}
+
+void registerProcGenBenchmarks() {
+	registerNoiseBenchmarks();
+	registerFractalBenchmarks();
+	registerMeshBenchmarks();
+	registerPostProcessBenchmarks();
+	registerLandCacheBenchmarks();
+}
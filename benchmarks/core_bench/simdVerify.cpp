@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "simdVerify.h"
+
+//Plain scalar products with the summation order of the ewMath scalar paths, the reference every kernel is checked against.
+//Column major: element (col, row) is at col * 4 + row
+static void referenceMulMat4(const float* l, const float* r, float* out) {
+	for (int col = 0; col < 4; col++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			out[col * 4 + row] = l[0 * 4 + row] * r[col * 4 + 0] + l[1 * 4 + row] * r[col * 4 + 1] + l[2 * 4 + row] * r[col * 4 + 2] + l[3 * 4 + row] * r[col * 4 + 3];
+		}
+	}
+}
+
+static void referenceMulVec4(const float* m, const float* v, float* out) {
+	for (int row = 0; row < 4; row++)
+	{
+		out[row] = m[0 * 4 + row] * v[0] + m[1 * 4 + row] * v[1] + m[2 * 4 + row] * v[2] + m[3 * 4 + row] * v[3];
+	}
+}
+
+//Distance in units in the last place, 0 when bit identical. +0 and -0 are 0 apart
+static uint32_t ulpDistance(float a, float b) {
+	int32_t ia, ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	//Map sign-magnitude to a monotonic integer line
+	if (ia < 0)
+		ia = INT32_MIN - ia;
+	if (ib < 0)
+		ib = INT32_MIN - ib;
+	return ia > ib ? (uint32_t)ia - (uint32_t)ib : (uint32_t)ib - (uint32_t)ia;
+}
+
+struct Comparison {
+	size_t mismatches = 0;
+	uint32_t maxUlps = 0;
+};
+
+static Comparison compare(const std::vector<float>& expected, const std::vector<float>& actual) {
+	Comparison c;
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		uint32_t ulps = ulpDistance(expected[i], actual[i]);
+		if (ulps > 0)
+			c.mismatches++;
+		if (ulps > c.maxUlps)
+			c.maxUlps = ulps;
+	}
+	return c;
+}
+
+static float randomValue() {
+	//Mostly transform sized values, some large ones to exercise rounding
+	float t = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	return rand() % 8 == 0 ? t * 1.0e4f : t * 10.0f;
+}
+
+//Checks Mat4*Mat4 and Mat4*Vec4 of every SIMD variant against the scalar reference.
+//The SIMD paths sum in the scalar order, so results must be bit identical. Returns the process exit code
+int verifySimd() {
+	const size_t COUNT = 100000;
+	const uint32_t MAX_ULPS = 0;
+	srand(1);
+	std::vector<float> l(COUNT * 16), r(COUNT * 16), v(COUNT * 4);
+	for (float& x : l) x = randomValue();
+	for (float& x : r) x = randomValue();
+	for (float& x : v) x = randomValue();
+	//A few exact cases: identity, zeros and signed zeros
+	for (int i = 0; i < 16; i++)
+	{
+		l[i] = i % 5 == 0 ? 1.0f : 0.0f;
+		r[16 + i] = -0.0f;
+	}
+
+	std::vector<float> expectedMat(COUNT * 16), expectedVec(COUNT * 4);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		referenceMulMat4(&l[i * 16], &r[i * 16], &expectedMat[i * 16]);
+		referenceMulVec4(&l[i * 16], &v[i * 4], &expectedVec[i * 4]);
+	}
+
+	const simdVerify::Kernel kernels[] = { simdVerify::noSimdKernel(), simdVerify::defaultKernel(), simdVerify::avxKernel() };
+	printf("%-20s %14s %10s %14s %10s\n", "kernel", "Mat4*Mat4 diff", "max ulps", "Mat4*Vec4 diff", "max ulps");
+	bool passed = true;
+	std::vector<float> mat(COUNT * 16), vec(COUNT * 4);
+	for (const simdVerify::Kernel& kernel : kernels)
+	{
+		if (!kernel.available) {
+			printf("%-20s skipped, not supported by this compiler or CPU\n", kernel.name);
+			continue;
+		}
+		kernel.mulMat4(l.data(), r.data(), mat.data(), COUNT);
+		kernel.mulVec4(l.data(), v.data(), vec.data(), COUNT);
+		Comparison m = compare(expectedMat, mat);
+		Comparison c = compare(expectedVec, vec);
+		printf("%-20s %14zu %10u %14zu %10u\n", kernel.name, m.mismatches, m.maxUlps, c.mismatches, c.maxUlps);
+		if (m.maxUlps > MAX_ULPS || c.maxUlps > MAX_ULPS)
+			passed = false;
+	}
+	printf("%zu products each, %s\n", COUNT, passed ? "all bit identical to the scalar reference" : "FAILED");
+	return passed ? 0 : 1;
+}
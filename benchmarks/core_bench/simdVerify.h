@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+
+namespace simdVerify {
+	/// <summary>
+	/// Mat4*Mat4 and Mat4*Vec4 as compiled with one set of ewMath SIMD settings.
+	/// Matrices are 16 floats in Mat4's column major layout, vectors are 4 floats.
+	/// </summary>
+	struct Kernel {
+		const char* name;
+		bool available; //false when the compiler or the CPU lacks the instructions
+		void(*mulMat4)(const float* l, const float* r, float* out, size_t count);
+		void(*mulVec4)(const float* m, const float* v, float* out, size_t count);
+	};
+
+	//One translation unit per variant, each built with its own SIMD settings
+	Kernel noSimdKernel(); //EW_NO_SIMD
+	Kernel defaultKernel(); //core_bench's own flags, SSE on x86-64
+	Kernel avxKernel(); //built with AVX enabled
+}
@@ -0,0 +1,31 @@
+//simdVerify kernel built with AVX enabled (-mavx or /arch:AVX, set in CMakeLists.txt)
+#define SIMD_VERIFY_NAMESPACE ew_avx
+#include "simdVerifyKernel.inl"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(EW_SIMD_AVX)
+//AVX instructions and the OS saving ymm registers
+static bool cpuHasAvx() {
+#if defined(__GNUC__)
+	return __builtin_cpu_supports("avx");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	return avx && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+	return false;
+#endif
+}
+#endif
+
+simdVerify::Kernel simdVerify::avxKernel() {
+#if defined(EW_SIMD_AVX)
+	return { "AVX", cpuHasAvx(), mulMat4, mulVec4 };
+#else
+	return { "AVX", false, mulMat4, mulVec4 };
+#endif
+}
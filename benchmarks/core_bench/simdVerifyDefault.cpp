@@ -0,0 +1,13 @@
+//simdVerify kernel with the SIMD paths core_bench itself is built with
+#define SIMD_VERIFY_NAMESPACE ew_default
+#include "simdVerifyKernel.inl"
+
+simdVerify::Kernel simdVerify::defaultKernel() {
+#if defined(EW_SIMD_AVX)
+	return { "default (AVX)", true, mulMat4, mulVec4 };
+#elif defined(EW_SIMD_SSE)
+	return { "default (SSE)", true, mulMat4, mulVec4 };
+#else
+	return { "default (scalar)", true, mulMat4, mulVec4 };
+#endif
+}
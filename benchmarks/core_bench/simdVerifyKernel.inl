@@ -0,0 +1,53 @@
+//Body shared by the simdVerify kernels. The including file sets the ewMath SIMD macros and SIMD_VERIFY_NAMESPACE first.
+//ew is renamed to SIMD_VERIFY_NAMESPACE so every variant gets its own copies of the inline operators and Mat4/Vec4 layouts,
+//otherwise the linker would keep a single copy of each and every kernel would run the same code.
+#include <math.h>
+#include <cstddef>
+#include <random>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#include "simdVerify.h"
+
+#define ew SIMD_VERIFY_NAMESPACE
+#include <ew/ewMath/mat4.h>
+
+namespace {
+	ew::Vec4 loadVec4(const float* v) {
+		return ew::Vec4(v[0], v[1], v[2], v[3]);
+	}
+	void storeVec4(float* out, const ew::Vec4& v) {
+		out[0] = v.x;
+		out[1] = v.y;
+		out[2] = v.z;
+		out[3] = v.w;
+	}
+	//Through get() rather than operator[], which reads the float array as a Vec4 and breaks strict aliasing at -O2
+	void storeMat4(float* out, const ew::Mat4& m) {
+		for (int col = 0; col < 4; col++)
+			for (int row = 0; row < 4; row++)
+				out[col * 4 + row] = m.get(col, row);
+	}
+	ew::Mat4 loadMat4(const float* m) {
+		return ew::Mat4(loadVec4(m), loadVec4(m + 4), loadVec4(m + 8), loadVec4(m + 12));
+	}
+
+	void mulMat4(const float* l, const float* r, float* out, size_t count) {
+		for (size_t i = 0; i < count; i++)
+		{
+			storeMat4(out + i * 16, loadMat4(l + i * 16) * loadMat4(r + i * 16));
+		}
+	}
+
+	void mulVec4(const float* m, const float* v, float* out, size_t count) {
+		for (size_t i = 0; i < count; i++)
+		{
+			storeVec4(out + i * 4, loadMat4(m + i * 16) * loadVec4(v + i * 4));
+		}
+	}
+}
+#undef ew
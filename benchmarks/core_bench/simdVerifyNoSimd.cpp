@@ -0,0 +1,8 @@
+//simdVerify kernel with every ewMath SIMD path disabled
+#define EW_NO_SIMD
+#define SIMD_VERIFY_NAMESPACE ew_noSimd
+#include "simdVerifyKernel.inl"
+
+simdVerify::Kernel simdVerify::noSimdKernel() {
+	return { "EW_NO_SIMD", true, mulMat4, mulVec4 };
+}
@@ -0,0 +1,153 @@
+/*
+	Batched transforms over arrays of Vec3.
+	All functions treat m as an affine matrix: the resulting w is dropped without a perspective divide.
+	Output may alias input (in == out) for in-place transforms.
+*/
+
+#pragma once
+#include <cstddef>
+#include "simd.h"
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	/// <summary>
+	/// Transforms count points (w = 1) by m. Strides are in bytes so positions can be read straight out of interleaved vertex arrays.
+	/// </summary>
+	/// <param name="m">Affine transform</param>
+	/// <param name="in">First input point</param>
+	/// <param name="inStride">Bytes between consecutive input points</param>
+	/// <param name="out">First output point</param>
+	/// <param name="outStride">Bytes between consecutive output points</param>
+	/// <param name="count">Number of points</param>
+	inline void TransformPoints(const Mat4& m, const Vec3* in, size_t inStride, Vec3* out, size_t outStride, size_t count) {
+		const char* src = reinterpret_cast<const char*>(in);
+		char* dst = reinterpret_cast<char*>(out);
+#if defined(EW_SIMD_SSE)
+		const __m128 c0 = _mm_loadu_ps(&m[0].x);
+		const __m128 c1 = _mm_loadu_ps(&m[1].x);
+		const __m128 c2 = _mm_loadu_ps(&m[2].x);
+		const __m128 c3 = _mm_loadu_ps(&m[3].x);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vec3& p = *reinterpret_cast<const Vec3*>(src + i * inStride);
+			__m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+			r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+			r = _mm_add_ps(r, c3);
+			alignas(16) float t[4];
+			_mm_store_ps(t, r);
+			Vec3& o = *reinterpret_cast<Vec3*>(dst + i * outStride);
+			o.x = t[0]; o.y = t[1]; o.z = t[2];
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vec3 p = *reinterpret_cast<const Vec3*>(src + i * inStride);
+			Vec3& o = *reinterpret_cast<Vec3*>(dst + i * outStride);
+			o.x = m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z + m[3][0];
+			o.y = m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z + m[3][1];
+			o.z = m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z + m[3][2];
+		}
+#endif
+	}
+
+	/// <summary>
+	/// Transforms count direction vectors (w = 0) by m. Translation is ignored.
+	/// For surface normals pass the normal matrix rather than the model matrix.
+	/// </summary>
+	inline void TransformVectors(const Mat4& m, const Vec3* in, size_t inStride, Vec3* out, size_t outStride, size_t count) {
+		const char* src = reinterpret_cast<const char*>(in);
+		char* dst = reinterpret_cast<char*>(out);
+#if defined(EW_SIMD_SSE)
+		const __m128 c0 = _mm_loadu_ps(&m[0].x);
+		const __m128 c1 = _mm_loadu_ps(&m[1].x);
+		const __m128 c2 = _mm_loadu_ps(&m[2].x);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vec3& p = *reinterpret_cast<const Vec3*>(src + i * inStride);
+			__m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+			r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+			alignas(16) float t[4];
+			_mm_store_ps(t, r);
+			Vec3& o = *reinterpret_cast<Vec3*>(dst + i * outStride);
+			o.x = t[0]; o.y = t[1]; o.z = t[2];
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vec3 p = *reinterpret_cast<const Vec3*>(src + i * inStride);
+			Vec3& o = *reinterpret_cast<Vec3*>(dst + i * outStride);
+			o.x = m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z;
+			o.y = m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z;
+			o.z = m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z;
+		}
+#endif
+	}
+
+	//Tightly packed AoS overloads
+	inline void TransformPoints(const Mat4& m, const Vec3* in, Vec3* out, size_t count) {
+		TransformPoints(m, in, sizeof(Vec3), out, sizeof(Vec3), count);
+	}
+	inline void TransformVectors(const Mat4& m, const Vec3* in, Vec3* out, size_t count) {
+		TransformVectors(m, in, sizeof(Vec3), out, sizeof(Vec3), count);
+	}
+
+	/// <summary>
+	/// SoA point transform. Processes 8 (AVX) or 4 (SSE) points per iteration.
+	/// Output arrays may alias the matching input arrays.
+	/// </summary>
+	/// <param name="w">Homogeneous coordinate, 1 for points and 0 for vectors</param>
+	inline void TransformSoA(const Mat4& m, const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t count, float w = 1.0f) {
+		const float tx = m[3][0] * w, ty = m[3][1] * w, tz = m[3][2] * w;
+		size_t i = 0;
+#if defined(EW_SIMD_AVX)
+		{
+			const __m256 m00 = _mm256_set1_ps(m[0][0]), m10 = _mm256_set1_ps(m[1][0]), m20 = _mm256_set1_ps(m[2][0]), t0 = _mm256_set1_ps(tx);
+			const __m256 m01 = _mm256_set1_ps(m[0][1]), m11 = _mm256_set1_ps(m[1][1]), m21 = _mm256_set1_ps(m[2][1]), t1 = _mm256_set1_ps(ty);
+			const __m256 m02 = _mm256_set1_ps(m[0][2]), m12 = _mm256_set1_ps(m[1][2]), m22 = _mm256_set1_ps(m[2][2]), t2 = _mm256_set1_ps(tz);
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256 px = _mm256_loadu_ps(x + i);
+				const __m256 py = _mm256_loadu_ps(y + i);
+				const __m256 pz = _mm256_loadu_ps(z + i);
+				__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, px), _mm256_mul_ps(m10, py)), _mm256_mul_ps(m20, pz)), t0);
+				__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, px), _mm256_mul_ps(m11, py)), _mm256_mul_ps(m21, pz)), t1);
+				__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, px), _mm256_mul_ps(m12, py)), _mm256_mul_ps(m22, pz)), t2);
+				_mm256_storeu_ps(ox + i, rx);
+				_mm256_storeu_ps(oy + i, ry);
+				_mm256_storeu_ps(oz + i, rz);
+			}
+		}
+#endif
+#if defined(EW_SIMD_SSE)
+		{
+			const __m128 m00 = _mm_set1_ps(m[0][0]), m10 = _mm_set1_ps(m[1][0]), m20 = _mm_set1_ps(m[2][0]), t0 = _mm_set1_ps(tx);
+			const __m128 m01 = _mm_set1_ps(m[0][1]), m11 = _mm_set1_ps(m[1][1]), m21 = _mm_set1_ps(m[2][1]), t1 = _mm_set1_ps(ty);
+			const __m128 m02 = _mm_set1_ps(m[0][2]), m12 = _mm_set1_ps(m[1][2]), m22 = _mm_set1_ps(m[2][2]), t2 = _mm_set1_ps(tz);
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128 px = _mm_loadu_ps(x + i);
+				const __m128 py = _mm_loadu_ps(y + i);
+				const __m128 pz = _mm_loadu_ps(z + i);
+				__m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, px), _mm_mul_ps(m10, py)), _mm_mul_ps(m20, pz)), t0);
+				__m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, px), _mm_mul_ps(m11, py)), _mm_mul_ps(m21, pz)), t1);
+				__m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, px), _mm_mul_ps(m12, py)), _mm_mul_ps(m22, pz)), t2);
+				_mm_storeu_ps(ox + i, rx);
+				_mm_storeu_ps(oy + i, ry);
+				_mm_storeu_ps(oz + i, rz);
+			}
+		}
+#endif
+		//Remainder after the vector loops, every point without SIMD. Counted from 0 so the trip count is plainly count - i
+		const size_t tail = count - i;
+		x += i; y += i; z += i;
+		ox += i; oy += i; oz += i;
+		for (size_t k = 0; k < tail; k++)
+		{
+			const float px = x[k], py = y[k], pz = z[k];
+			ox[k] = m[0][0] * px + m[1][0] * py + m[2][0] * pz + tx;
+			oy[k] = m[0][1] * px + m[1][1] * py + m[2][1] * pz + ty;
+			oz[k] = m[0][2] * px + m[1][2] * py + m[2][2] * pz + tz;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/*
+	Bounding volumes used for visibility tests.
+*/
+
+#pragma once
+#include <float.h>
+#include <math.h>
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	//Axis aligned bounding box. Default constructed boxes are empty (min > max) so any point expands them.
+	struct AABB {
+		ew::Vec3 min = ew::Vec3(FLT_MAX);
+		ew::Vec3 max = ew::Vec3(-FLT_MAX);
+
+		constexpr bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+		constexpr ew::Vec3 center() const { return (min + max) * 0.5f; }
+		constexpr ew::Vec3 extents() const { return (max - min) * 0.5f; }
+		inline void expand(const ew::Vec3& p) {
+			min = ew::Vec3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+			max = ew::Vec3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+		}
+	};
+
+	struct BoundingSphere {
+		ew::Vec3 center = ew::Vec3(0);
+		float radius = 0.0f;
+	};
+
+	/// <summary>
+	/// Bounding box of box b after transforming by affine matrix m (Arvo's method).
+	/// </summary>
+	inline AABB TransformAABB(const AABB& b, const ew::Mat4& m) {
+		const ew::Vec3 c = b.center();
+		const ew::Vec3 e = b.extents();
+		AABB out;
+		for (int i = 0; i < 3; i++)
+		{
+			float center = m[3][i] + m[0][i] * c.x + m[1][i] * c.y + m[2][i] * c.z;
+			float extent = fabsf(m[0][i]) * e.x + fabsf(m[1][i]) * e.y + fabsf(m[2][i]) * e.z;
+			out.min[i] = center - extent;
+			out.max[i] = center + extent;
+		}
+		return out;
+	}
+
+	//Smallest sphere containing box b
+	inline BoundingSphere SphereFromAABB(const AABB& b) {
+		BoundingSphere s;
+		s.center = b.center();
+		s.radius = ew::Magnitude(b.extents());
+		return s;
+	}
+
+	/// <summary>
+	/// Sphere s after transforming by affine matrix m. The radius is scaled by the largest axis scale so the result stays conservative.
+	/// </summary>
+	inline BoundingSphere TransformSphere(const BoundingSphere& s, const ew::Mat4& m) {
+		BoundingSphere out;
+		out.center = (m * ew::Vec4(s.center, 1.0f)).toVec3();
+		float sx = ew::Dot(m[0].toVec3(), m[0].toVec3());
+		float sy = ew::Dot(m[1].toVec3(), m[1].toVec3());
+		float sz = ew::Dot(m[2].toVec3(), m[2].toVec3());
+		out.radius = s.radius * sqrtf(fmaxf(sx, fmaxf(sy, sz)));
+		return out;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+	Compile time checks of the constexpr ewMath helpers.
+	Nothing here runs, core fails to build if any of them stops holding or stops being a constant expression.
+*/
+
+#include "ewMath.h"
+#include "transformations.h"
+#include "../../wm/transformations.h"
+
+namespace ew {
+	namespace {
+		constexpr bool Equal(const Vec3& a, const Vec3& b) {
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+		constexpr bool Equal(const Vec4& a, const Vec4& b) {
+			return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+		}
+		constexpr bool Equal(const Mat4& a, const Mat4& b) {
+			for (int col = 0; col < 4; col++)
+				for (int row = 0; row < 4; row++)
+					if (a.get(col, row) != b.get(col, row))
+						return false;
+			return true;
+		}
+		constexpr bool Equal(const Mat3& a, const Mat3& b) {
+			for (int col = 0; col < 3; col++)
+				for (int row = 0; row < 3; row++)
+					if (a.get(col, row) != b.get(col, row))
+						return false;
+			return true;
+		}
+		constexpr Vec3 Accumulate() {
+			Vec3 v(1.0f, 2.0f, 3.0f);
+			v += Vec3(1.0f);
+			v -= Vec3(0.0f, 1.0f, 2.0f);
+			v *= 4.0f;
+			v /= 2.0f;
+			return v;
+		}
+
+		//Vectors
+		static_assert(Equal(Vec3(1.0f, 2.0f, 3.0f) + Vec3(4.0f, 5.0f, 6.0f), Vec3(5.0f, 7.0f, 9.0f)), "Vec3 +");
+		static_assert(Equal(Vec3(1.0f, 2.0f, 3.0f) - Vec3(4.0f, 5.0f, 6.0f), Vec3(-3.0f)), "Vec3 -");
+		static_assert(Equal(2.0f * Vec3(1.0f, 2.0f, 3.0f) / 4.0f, Vec3(0.5f, 1.0f, 1.5f)), "Vec3 * and /");
+		static_assert(Equal(-Vec3(1.0f, -2.0f, 0.5f), Vec3(-1.0f, 2.0f, -0.5f)), "Vec3 negate");
+		static_assert(Equal(Accumulate(), Vec3(4.0f, 4.0f, 4.0f)), "Vec3 compound assignment");
+		static_assert(Dot(Vec3(1.0f, 2.0f, 3.0f), Vec3(4.0f, -5.0f, 6.0f)) == 12.0f, "Vec3 Dot");
+		static_assert(Equal(Cross(Vec3(1.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f)), Vec3(0.0f, 0.0f, 1.0f)), "Cross x y");
+		static_assert(Equal(Cross(Vec3(0.0f, 0.0f, 1.0f), Vec3(0.0f, 1.0f, 0.0f)), Vec3(-1.0f, 0.0f, 0.0f)), "Cross z y");
+		static_assert(Dot(Vec2(3.0f, 4.0f), Vec2(3.0f, 4.0f)) == 25.0f, "Vec2 Dot");
+		static_assert(Dot(Vec4(1.0f, 2.0f, 3.0f, 4.0f), Vec4(1.0f)) == 10.0f, "Vec4 Dot");
+		static_assert(Equal(Vec4(Vec3(1.0f, 2.0f, 3.0f), 1.0f).toVec3(), Vec3(1.0f, 2.0f, 3.0f)), "Vec4 from and to Vec3");
+
+		//Scalars
+		static_assert(Radians(180.0f) == PI, "Radians");
+		static_assert(Degrees(PI) == 180.0f, "Degrees");
+		static_assert(Sign(0.0f) == 1.0f && Sign(-2.0f) == -1.0f, "Sign");
+
+		//Matrices
+		constexpr Mat4 M(
+			1.0f, 2.0f, 3.0f, 4.0f,
+			5.0f, 6.0f, 7.0f, 8.0f,
+			9.0f, 10.0f, 11.0f, 12.0f,
+			13.0f, 14.0f, 15.0f, 16.0f
+		);
+		static_assert(M.get(3, 0) == 4.0f && M.get(0, 3) == 13.0f, "Mat4 constructor arguments are rows, storage is column major");
+		static_assert(Equal(Mat4(Vec4(1.0f, 5.0f, 9.0f, 13.0f), Vec4(2.0f, 6.0f, 10.0f, 14.0f), Vec4(3.0f, 7.0f, 11.0f, 15.0f), Vec4(4.0f, 8.0f, 12.0f, 16.0f)), M), "Mat4 from columns");
+		static_assert(Equal(Transpose(Transpose(M)), M), "Transpose twice");
+		static_assert(Transpose(M).get(3, 0) == 13.0f, "Transpose");
+		static_assert(Equal(IdentityMatrix(), Identity()), "IdentityMatrix and Identity");
+		static_assert(Equal(Transpose(Identity()), Identity()), "Transpose of identity");
+		static_assert(Equal(Scale(Vec3(2.0f, 3.0f, 4.0f)), Mat4(2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f, 4.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f)), "Scale");
+		static_assert(Translate(Vec3(2.0f, 3.0f, 4.0f)).get(3, 0) == 2.0f && Translate(Vec3(2.0f, 3.0f, 4.0f)).get(3, 2) == 4.0f, "Translate is in the last column");
+		static_assert(Equal(Mat3(M), Mat3(1.0f, 2.0f, 3.0f, 5.0f, 6.0f, 7.0f, 9.0f, 10.0f, 11.0f)), "Mat3 from the upper left of Mat4");
+		static_assert(Equal(Transpose(Mat3(M)), Mat3(Transpose(M))), "Mat3 Transpose");
+
+		//wm transformations match ew
+		static_assert(Equal(wm::Identity(), Identity()), "wm::Identity");
+		static_assert(Equal(wm::Sacle(Vec3(2.0f, 3.0f, 4.0f)), Scale(Vec3(2.0f, 3.0f, 4.0f))), "wm::Sacle");
+		static_assert(Equal(wm::Translate(Vec3(2.0f, 3.0f, 4.0f)), Translate(Vec3(2.0f, 3.0f, 4.0f))), "wm::Translate");
+
+#if defined(__cpp_lib_is_constant_evaluated)
+		//Mat4 products are constant expressions from C++20, through their scalar branch
+		static_assert(Equal(M * Identity(), M) && Equal(Identity() * M, M), "Mat4 * identity");
+		static_assert(Equal(Translate(Vec3(1.0f, 2.0f, 3.0f)) * Vec4(1.0f, 1.0f, 1.0f, 1.0f), Vec4(2.0f, 3.0f, 4.0f, 1.0f)), "Translate a point");
+		static_assert(Equal(Translate(Vec3(1.0f, 2.0f, 3.0f)) * Vec4(1.0f, 1.0f, 1.0f, 0.0f), Vec4(1.0f, 1.0f, 1.0f, 0.0f)), "Translate ignores vectors");
+		static_assert(Equal(Scale(Vec3(2.0f)) * Translate(Vec3(1.0f)) * Vec4(1.0f, 0.0f, 0.0f, 1.0f), Vec4(4.0f, 2.0f, 2.0f, 1.0f)), "Scale after translate");
+		static_assert(Equal(Transpose(M * Scale(Vec3(2.0f, 3.0f, 4.0f))), Scale(Vec3(2.0f, 3.0f, 4.0f)) * Transpose(M)), "Transpose of a product");
+#endif
+	}
+}
@@ -9,16 +9,17 @@
 #include "vec2.h"
 #include "vec3.h"
 #include "mat4.h"
+#include "mat3.h"
 
 namespace ew {
 	constexpr float PI = 3.14159265359f;
 	constexpr float TAU = 6.283185307179586f;
 	constexpr float DEG2RAD = (PI / 180.0f);
 	constexpr float RAD2DEG = (180.0f / PI);
-	inline float Radians(float degrees) {
+	constexpr float Radians(float degrees) {
 		return degrees * DEG2RAD;
 	}
-	inline float Degrees(float radians) {
+	constexpr float Degrees(float radians) {
 		return radians * RAD2DEG;
 	}
 	inline float RandomRange(float min, float max) {
@@ -33,7 +34,7 @@ namespace ew {
 	/// </summary>
 	/// <param name="x"></param>
 	/// <returns>1 when x>=0, -1 if x<0</returns>
-	inline float Sign(float x) {
+	constexpr float Sign(float x) {
 		return x >= 0 ? 1 : -1;
 	}
 }
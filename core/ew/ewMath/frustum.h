@@ -0,0 +1,173 @@
+/*
+	View frustum extraction and culling tests.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "simd.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "bounds.h"
+
+namespace ew {
+	//Six planes stored as (normal.xyz, d). A point p is inside a plane when Dot(normal, p) + d >= 0.
+	struct Frustum {
+		enum Plane { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, COUNT };
+		ew::Vec4 planes[COUNT];
+	};
+
+	/// <summary>
+	/// Extracts world space frustum planes from a view projection matrix (Gribb and Hartmann).
+	/// Pass Camera::ProjectionMatrix() * Camera::ViewMatrix() for world space planes.
+	/// </summary>
+	inline Frustum ExtractFrustum(const ew::Mat4& viewProjection) {
+		const ew::Mat4& m = viewProjection;
+		//Rows of the column major matrix
+		ew::Vec4 row[4];
+		for (int i = 0; i < 4; i++)
+		{
+			row[i] = ew::Vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+		}
+		//Left/right = row3 +/- row0, bottom/top = row3 +/- row1, near/far = row3 +/- row2
+		Frustum f;
+		for (int i = 0; i < Frustum::COUNT; i++)
+		{
+			const ew::Vec4& r = row[i / 2];
+			const float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+			//Vec4 operators leave w untouched, so combine components by hand
+			ew::Vec4 p = ew::Vec4(row[3].x + sign * r.x, row[3].y + sign * r.y, row[3].z + sign * r.z, row[3].w + sign * r.w);
+			float invLength = 1.0f / ew::Magnitude(p.toVec3());
+			f.planes[i] = ew::Vec4(p.x * invLength, p.y * invLength, p.z * invLength, p.w * invLength);
+		}
+		return f;
+	}
+
+	inline bool IsVisible(const Frustum& f, const BoundingSphere& s) {
+		for (int i = 0; i < Frustum::COUNT; i++)
+		{
+			const ew::Vec4& p = f.planes[i];
+			if (p.x * s.center.x + p.y * s.center.y + p.z * s.center.z + p.w < -s.radius)
+				return false;
+		}
+		return true;
+	}
+
+	inline bool IsVisible(const Frustum& f, const AABB& b) {
+		const ew::Vec3 c = b.center();
+		const ew::Vec3 e = b.extents();
+		for (int i = 0; i < Frustum::COUNT; i++)
+		{
+			const ew::Vec4& p = f.planes[i];
+			float d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+			float r = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+			if (d + r < 0)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Batched sphere test over SoA arrays, 4 spheres per iteration with SSE.
+	/// </summary>
+	/// <param name="visible">Output, 1 for visible and 0 for culled per sphere</param>
+	/// <returns>Number of visible spheres</returns>
+	inline size_t CullSpheres(const Frustum& f, const float* x, const float* y, const float* z, const float* radius, size_t count, uint8_t* visible) {
+		size_t numVisible = 0;
+		size_t i = 0;
+#if defined(EW_SIMD_SSE)
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 px = _mm_loadu_ps(x + i);
+			const __m128 py = _mm_loadu_ps(y + i);
+			const __m128 pz = _mm_loadu_ps(z + i);
+			const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < Frustum::COUNT; p++)
+			{
+				const ew::Vec4& pl = f.planes[p];
+				__m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), px), _mm_mul_ps(_mm_set1_ps(pl.y), py));
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.z), pz));
+				d = _mm_add_ps(d, _mm_set1_ps(pl.w));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+			}
+			const int mask = _mm_movemask_ps(inside);
+			for (int k = 0; k < 4; k++)
+			{
+				visible[i + k] = (mask >> k) & 1;
+				numVisible += visible[i + k];
+			}
+		}
+#endif
+		//Remainder after the vector loop, counted from 0 so the trip count is plainly count - i
+		const size_t tail = count - i;
+		x += i; y += i; z += i; radius += i;
+		visible += i;
+		for (size_t k = 0; k < tail; k++)
+		{
+			BoundingSphere s;
+			s.center = ew::Vec3(x[k], y[k], z[k]);
+			s.radius = radius[k];
+			visible[k] = IsVisible(f, s) ? 1 : 0;
+			numVisible += visible[k];
+		}
+		return numVisible;
+	}
+
+	/// <summary>
+	/// Batched box test over SoA arrays of centers and half extents, 4 boxes per iteration with SSE.
+	/// </summary>
+	/// <param name="visible">Output, 1 for visible and 0 for culled per box</param>
+	/// <returns>Number of visible boxes</returns>
+	inline size_t CullAABBs(const Frustum& f, const float* cx, const float* cy, const float* cz, const float* ex, const float* ey, const float* ez, size_t count, uint8_t* visible) {
+		size_t numVisible = 0;
+		size_t i = 0;
+#if defined(EW_SIMD_SSE)
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 px = _mm_loadu_ps(cx + i);
+			const __m128 py = _mm_loadu_ps(cy + i);
+			const __m128 pz = _mm_loadu_ps(cz + i);
+			const __m128 hx = _mm_loadu_ps(ex + i);
+			const __m128 hy = _mm_loadu_ps(ey + i);
+			const __m128 hz = _mm_loadu_ps(ez + i);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < Frustum::COUNT; p++)
+			{
+				const __m128 plane = _mm_loadu_ps(&f.planes[p].x);
+				const __m128 absPlane = _mm_and_ps(plane, absMask);
+				const ew::Vec4& pl = f.planes[p];
+				__m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), px), _mm_mul_ps(_mm_set1_ps(pl.y), py));
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.z), pz));
+				d = _mm_add_ps(d, _mm_set1_ps(pl.w));
+				__m128 r = _mm_mul_ps(_mm_shuffle_ps(absPlane, absPlane, 0x00), hx);
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(absPlane, absPlane, 0x55), hy));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(absPlane, absPlane, 0xAA), hz));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+			}
+			const int mask = _mm_movemask_ps(inside);
+			for (int k = 0; k < 4; k++)
+			{
+				visible[i + k] = (mask >> k) & 1;
+				numVisible += visible[i + k];
+			}
+		}
+#endif
+		//Remainder after the vector loop, counted from 0 so the trip count is plainly count - i
+		const size_t tail = count - i;
+		cx += i; cy += i; cz += i;
+		ex += i; ey += i; ez += i;
+		visible += i;
+		for (size_t k = 0; k < tail; k++)
+		{
+			AABB b;
+			b.min = ew::Vec3(cx[k] - ex[k], cy[k] - ey[k], cz[k] - ez[k]);
+			b.max = ew::Vec3(cx[k] + ex[k], cy[k] + ey[k], cz[k] + ez[k]);
+			visible[k] = IsVisible(f, b) ? 1 : 0;
+			numVisible += visible[k];
+		}
+		return numVisible;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+	3x3 matrix, mainly used for normal matrices.
+*/
+
+#pragma once
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	//Column major, same layout conventions as Mat4
+	struct Mat3 {
+	private:
+		float n[3][3];
+	public:
+		Mat3() = default;
+		constexpr Mat3(float n00)
+			:n{ { n00, n00, n00 },
+				{ n00, n00, n00 },
+				{ n00, n00, n00 } }
+		{};
+		constexpr Mat3(float n00, float n10, float n20,
+			 float n01, float n11, float n21,
+			 float n02, float n12, float n22)
+			:n{ { n00, n01, n02 },
+				{ n10, n11, n12 },
+				{ n20, n21, n22 } }
+		{};
+		constexpr Mat3(const Vec3& a, const Vec3& b, const Vec3& c)
+			:n{ { a.x, a.y, a.z },
+				{ b.x, b.y, b.z },
+				{ c.x, c.y, c.z } }
+		{}
+		//Upper left 3x3 of m
+		constexpr explicit Mat3(const Mat4& m)
+			:n{ { m.get(0, 0), m.get(0, 1), m.get(0, 2) },
+				{ m.get(1, 0), m.get(1, 1), m.get(1, 2) },
+				{ m.get(2, 0), m.get(2, 1), m.get(2, 2) } }
+		{}
+		constexpr float get(int col, int row) const {
+			return n[col][row];
+		}
+		inline Vec3& operator[](int i) {
+			return (*reinterpret_cast<Vec3*>(n[i]));
+		}
+		inline const Vec3& operator[](int i) const {
+			return (*reinterpret_cast<const Vec3*>(n[i]));
+		}
+		inline friend Vec3 operator * (const Mat3& m, const Vec3& v) {
+			return Vec3(
+				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z,
+				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z,
+				m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z
+			);
+		}
+		inline friend Mat3 operator * (const Mat3& l, const Mat3& r) {
+			return Mat3(l * r[0], l * r[1], l * r[2]);
+		}
+	};
+	constexpr Mat3 Transpose(const Mat3& m) {
+		return Mat3(
+			m.get(0, 0), m.get(0, 1), m.get(0, 2),
+			m.get(1, 0), m.get(1, 1), m.get(1, 2),
+			m.get(2, 0), m.get(2, 1), m.get(2, 2)
+		);
+	}
+	/// <summary>
+	/// Inverse of a 3x3 matrix. Rows of the inverse are the cross products of the columns divided by the determinant.
+	/// </summary>
+	/// <param name="m">Must be invertible (non zero determinant)</param>
+	inline Mat3 Inverse(const Mat3& m) {
+		const Vec3& a = m[0];
+		const Vec3& b = m[1];
+		const Vec3& c = m[2];
+		Vec3 r0 = Cross(b, c);
+		Vec3 r1 = Cross(c, a);
+		Vec3 r2 = Cross(a, b);
+		float invDet = 1.0f / Dot(r2, c);
+		return Mat3(
+			r0.x * invDet, r0.y * invDet, r0.z * invDet,
+			r1.x * invDet, r1.y * invDet, r1.z * invDet,
+			r2.x * invDet, r2.y * invDet, r2.z * invDet
+		);
+	}
+}
@@ -4,36 +4,40 @@
 
 #pragma once
 #include "vec4.h"
+#include "simd.h"
 #include <cstddef>
 
 namespace ew {
-	struct Mat4 {
+	struct EW_ALIGN16 Mat4 {
 	private:
 		float n[4][4];
 	public:
 		Mat4() = default;
-		Mat4(float n00)
-		{
-			n[0][0] = n00; n[1][0] = n00; n[2][0] = n00; n[3][0] = n00;
-			n[0][1] = n00; n[1][1] = n00; n[2][1] = n00; n[3][1] = n00;
-			n[0][2] = n00; n[1][2] = n00; n[2][2] = n00; n[3][2] = n00;
-			n[0][3] = n00; n[1][3] = n00; n[2][3] = n00; n[3][3] = n00;
-		};
-		Mat4(float n00, float n10, float n20, float n30,
+		//Members are set in the initializer lists so every constructor is usable in constant expressions
+		constexpr Mat4(float n00)
+			:n{ { n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 },
+				{ n00, n00, n00, n00 } }
+		{};
+		constexpr Mat4(float n00, float n10, float n20, float n30,
 			 float n01, float n11, float n21, float n31,
 			 float n02, float n12, float n22, float n32,
 			 float n03, float n13, float n23, float n33)
-		{
-			n[0][0] = n00; n[1][0] = n10; n[2][0] = n20; n[3][0] = n30;
-			n[0][1] = n01; n[1][1] = n11; n[2][1] = n21; n[3][1] = n31;
-			n[0][2] = n02; n[1][2] = n12; n[2][2] = n22; n[3][2] = n32;
-			n[0][3] = n03; n[1][3] = n13; n[2][3] = n23; n[3][3] = n33;
-		};
-		Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d) {
-			n[0][0] = a.x; n[0][1] = a.y; n[0][2] = a.z; n[0][3] = a.w;
-			n[1][0] = b.x; n[1][1] = b.y; n[1][2] = b.z; n[1][3] = b.w;
-			n[2][0] = c.x; n[2][1] = c.y; n[2][2] = c.z; n[2][3] = c.w;
-			n[3][0] = d.x; n[3][1] = d.y; n[3][2] = d.z; n[3][3] = d.w;
+			:n{ { n00, n01, n02, n03 },
+				{ n10, n11, n12, n13 },
+				{ n20, n21, n22, n23 },
+				{ n30, n31, n32, n33 } }
+		{};
+		constexpr Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d)
+			:n{ { a.x, a.y, a.z, a.w },
+				{ b.x, b.y, b.z, b.w },
+				{ c.x, c.y, c.z, c.w },
+				{ d.x, d.y, d.z, d.w } }
+		{}
+		//Element access usable in constant expressions. operator[] reinterprets columns as Vec4 and is runtime only.
+		constexpr float get(int col, int row) const {
+			return n[col][row];
 		}
 		inline Vec4& operator[](int i) {
 			return (*reinterpret_cast<Vec4*>(n[i]));
@@ -41,40 +45,89 @@ namespace ew {
 		inline const Vec4& operator[](int i) const{
 			return (*reinterpret_cast<const Vec4*>(n[i]));
 		}
-		inline friend Vec4 operator * (const Mat4& m, const Vec4& v) {
+		//Columns are summed in the same order as the scalar path, so SIMD results match it bit for bit
+		inline friend EW_SIMD_CONSTEXPR Vec4 operator * (const Mat4& m, const Vec4& v) {
+#if defined(EW_SIMD_SSE)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				__m128 r = _mm_mul_ps(_mm_loadu_ps(m.n[0]), _mm_set1_ps(v.x));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[1]), _mm_set1_ps(v.y)));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[2]), _mm_set1_ps(v.z)));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m.n[3]), _mm_set1_ps(v.w)));
+				Vec4 out;
+				_mm_storeu_ps(&out.x, r);
+				return out;
+			}
+#endif
 			return Vec4(
-				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
-				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
-				m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * v.w,
-				m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
+				m.n[0][0] * v.x + m.n[1][0] * v.y + m.n[2][0] * v.z + m.n[3][0] * v.w,
+				m.n[0][1] * v.x + m.n[1][1] * v.y + m.n[2][1] * v.z + m.n[3][1] * v.w,
+				m.n[0][2] * v.x + m.n[1][2] * v.y + m.n[2][2] * v.z + m.n[3][2] * v.w,
+				m.n[0][3] * v.x + m.n[1][3] * v.y + m.n[2][3] * v.z + m.n[3][3] * v.w
 			);
 		}
-		inline friend Mat4 operator * (const Mat4& l, const Mat4& r) {
-			Mat4 m;
-			//Row 0
-			m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
-			m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
-			m[2][0] = l[0][0] * r[2][0] + l[1][0] * r[2][1] + l[2][0] * r[2][2] + l[3][0] * r[2][3];//dot(l_row_0,r_col_2)
-			m[3][0] = l[0][0] * r[3][0] + l[1][0] * r[3][1] + l[2][0] * r[3][2] + l[3][0] * r[3][3];//dot(l_row_0,r_col_3)
-			// Row 1		  		    		  		    		  		    		  
-			m[0][1] = l[0][1] * r[0][0] + l[1][1] * r[0][1] + l[2][1] * r[0][2] + l[3][1] * r[0][3];//dot(l_row_1,r_col_0)
-			m[1][1] = l[0][1] * r[1][0] + l[1][1] * r[1][1] + l[2][1] * r[1][2] + l[3][1] * r[1][3];//dot(l_row_1,r_col_1)
-			m[2][1] = l[0][1] * r[2][0] + l[1][1] * r[2][1] + l[2][1] * r[2][2] + l[3][1] * r[2][3];//dot(l_row_1,r_col_2)
-			m[3][1] = l[0][1] * r[3][0] + l[1][1] * r[3][1] + l[2][1] * r[3][2] + l[3][1] * r[3][3];//dot(l_row_1,r_col_3)
-			// Row  2		  		    		  		    		  		    		  
-			m[0][2] = l[0][2] * r[0][0] + l[1][2] * r[0][1] + l[2][2] * r[0][2] + l[3][2] * r[0][3];//dot(l_row_2,r_col_0)
-			m[1][2] = l[0][2] * r[1][0] + l[1][2] * r[1][1] + l[2][2] * r[1][2] + l[3][2] * r[1][3];//dot(l_row_2,r_col_1)
-			m[2][2] = l[0][2] * r[2][0] + l[1][2] * r[2][1] + l[2][2] * r[2][2] + l[3][2] * r[2][3];//dot(l_row_2,r_col_2)
-			m[3][2] = l[0][2] * r[3][0] + l[1][2] * r[3][1] + l[2][2] * r[3][2] + l[3][2] * r[3][3];//dot(l_row_2,r_col_3)
-			// Row  3		 			 		 			 		 			 		    
-			m[0][3] = l[0][3] * r[0][0] + l[1][3] * r[0][1] + l[2][3] * r[0][2] + l[3][3] * r[0][3];//dot(l_row_3,r_col_0)
-			m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
-			m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
-			m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
-			return m;		  
+		inline friend EW_SIMD_CONSTEXPR Mat4 operator * (const Mat4& l, const Mat4& r) {
+#if defined(EW_SIMD_SSE)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+#if defined(EW_SIMD_AVX)
+				Mat4 m;
+				//Two result columns per iteration. Left columns are duplicated into both 128 bit lanes.
+				const __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[0]));
+				const __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[1]));
+				const __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[2]));
+				const __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.n[3]));
+				for (int j = 0; j < 4; j += 2)
+				{
+					const __m256 rc = _mm256_loadu_ps(r.n[j]); //r columns j and j+1
+					__m256 o = _mm256_mul_ps(c0, _mm256_shuffle_ps(rc, rc, 0x00));
+					o = _mm256_add_ps(o, _mm256_mul_ps(c1, _mm256_shuffle_ps(rc, rc, 0x55)));
+					o = _mm256_add_ps(o, _mm256_mul_ps(c2, _mm256_shuffle_ps(rc, rc, 0xAA)));
+					o = _mm256_add_ps(o, _mm256_mul_ps(c3, _mm256_shuffle_ps(rc, rc, 0xFF)));
+					_mm256_storeu_ps(m.n[j], o);
+				}
+				return m;
+#elif defined(EW_SIMD_SSE)
+				Mat4 m;
+				const __m128 c0 = _mm_loadu_ps(l.n[0]);
+				const __m128 c1 = _mm_loadu_ps(l.n[1]);
+				const __m128 c2 = _mm_loadu_ps(l.n[2]);
+				const __m128 c3 = _mm_loadu_ps(l.n[3]);
+				for (int j = 0; j < 4; j++)
+				{
+					__m128 o = _mm_mul_ps(c0, _mm_set1_ps(r.n[j][0]));
+					o = _mm_add_ps(o, _mm_mul_ps(c1, _mm_set1_ps(r.n[j][1])));
+					o = _mm_add_ps(o, _mm_mul_ps(c2, _mm_set1_ps(r.n[j][2])));
+					o = _mm_add_ps(o, _mm_mul_ps(c3, _mm_set1_ps(r.n[j][3])));
+					_mm_storeu_ps(m.n[j], o);
+				}
+				return m;
+#endif
+			}
+#endif
+			return Mat4(
+				//Row 0
+				l.n[0][0] * r.n[0][0] + l.n[1][0] * r.n[0][1] + l.n[2][0] * r.n[0][2] + l.n[3][0] * r.n[0][3], //dot(l_row_0,r_col_0)
+				l.n[0][0] * r.n[1][0] + l.n[1][0] * r.n[1][1] + l.n[2][0] * r.n[1][2] + l.n[3][0] * r.n[1][3], //dot(l_row_0,r_col_1)
+				l.n[0][0] * r.n[2][0] + l.n[1][0] * r.n[2][1] + l.n[2][0] * r.n[2][2] + l.n[3][0] * r.n[2][3], //dot(l_row_0,r_col_2)
+				l.n[0][0] * r.n[3][0] + l.n[1][0] * r.n[3][1] + l.n[2][0] * r.n[3][2] + l.n[3][0] * r.n[3][3], //dot(l_row_0,r_col_3)
+				//Row 1
+				l.n[0][1] * r.n[0][0] + l.n[1][1] * r.n[0][1] + l.n[2][1] * r.n[0][2] + l.n[3][1] * r.n[0][3], //dot(l_row_1,r_col_0)
+				l.n[0][1] * r.n[1][0] + l.n[1][1] * r.n[1][1] + l.n[2][1] * r.n[1][2] + l.n[3][1] * r.n[1][3], //dot(l_row_1,r_col_1)
+				l.n[0][1] * r.n[2][0] + l.n[1][1] * r.n[2][1] + l.n[2][1] * r.n[2][2] + l.n[3][1] * r.n[2][3], //dot(l_row_1,r_col_2)
+				l.n[0][1] * r.n[3][0] + l.n[1][1] * r.n[3][1] + l.n[2][1] * r.n[3][2] + l.n[3][1] * r.n[3][3], //dot(l_row_1,r_col_3)
+				//Row 2
+				l.n[0][2] * r.n[0][0] + l.n[1][2] * r.n[0][1] + l.n[2][2] * r.n[0][2] + l.n[3][2] * r.n[0][3], //dot(l_row_2,r_col_0)
+				l.n[0][2] * r.n[1][0] + l.n[1][2] * r.n[1][1] + l.n[2][2] * r.n[1][2] + l.n[3][2] * r.n[1][3], //dot(l_row_2,r_col_1)
+				l.n[0][2] * r.n[2][0] + l.n[1][2] * r.n[2][1] + l.n[2][2] * r.n[2][2] + l.n[3][2] * r.n[2][3], //dot(l_row_2,r_col_2)
+				l.n[0][2] * r.n[3][0] + l.n[1][2] * r.n[3][1] + l.n[2][2] * r.n[3][2] + l.n[3][2] * r.n[3][3], //dot(l_row_2,r_col_3)
+				//Row 3
+				l.n[0][3] * r.n[0][0] + l.n[1][3] * r.n[0][1] + l.n[2][3] * r.n[0][2] + l.n[3][3] * r.n[0][3], //dot(l_row_3,r_col_0)
+				l.n[0][3] * r.n[1][0] + l.n[1][3] * r.n[1][1] + l.n[2][3] * r.n[1][2] + l.n[3][3] * r.n[1][3], //dot(l_row_3,r_col_1)
+				l.n[0][3] * r.n[2][0] + l.n[1][3] * r.n[2][1] + l.n[2][3] * r.n[2][2] + l.n[3][3] * r.n[2][3], //dot(l_row_3,r_col_2)
+				l.n[0][3] * r.n[3][0] + l.n[1][3] * r.n[3][1] + l.n[2][3] * r.n[3][2] + l.n[3][3] * r.n[3][3] //dot(l_row_3,r_col_3)
+			);
 		}
 	};
-	inline Mat4 IdentityMatrix() {
+	constexpr Mat4 IdentityMatrix() {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
@@ -82,4 +135,48 @@ namespace ew {
 			0.0f, 0.0f, 0.0f, 1.0f
 		);
 	}
+	constexpr Mat4 Transpose(const Mat4& m) {
+		return Mat4(
+			m.get(0, 0), m.get(0, 1), m.get(0, 2), m.get(0, 3),
+			m.get(1, 0), m.get(1, 1), m.get(1, 2), m.get(1, 3),
+			m.get(2, 0), m.get(2, 1), m.get(2, 2), m.get(2, 3),
+			m.get(3, 0), m.get(3, 1), m.get(3, 2), m.get(3, 3)
+		);
+	}
+	/// <summary>
+	/// General 4x4 inverse using 3D cross products of the columns (Lengyel, Foundations of Game Engine Development).
+	/// </summary>
+	/// <param name="m">Must be invertible (non zero determinant)</param>
+	inline Mat4 Inverse(const Mat4& m) {
+		const Vec3 a = m[0].toVec3();
+		const Vec3 b = m[1].toVec3();
+		const Vec3 c = m[2].toVec3();
+		const Vec3 d = m[3].toVec3();
+		const float x = m[0][3];
+		const float y = m[1][3];
+		const float z = m[2][3];
+		const float w = m[3][3];
+
+		Vec3 s = Cross(a, b);
+		Vec3 t = Cross(c, d);
+		Vec3 u = a * y - b * x;
+		Vec3 v = c * w - d * z;
+
+		float invDet = 1.0f / (Dot(s, v) + Dot(t, u));
+		s *= invDet;
+		t *= invDet;
+		u *= invDet;
+		v *= invDet;
+
+		Vec3 r0 = Cross(b, v) + t * y;
+		Vec3 r1 = Cross(v, a) - t * x;
+		Vec3 r2 = Cross(d, u) + s * w;
+		Vec3 r3 = Cross(u, c) - s * z;
+		return Mat4(
+			r0.x, r0.y, r0.z, -Dot(b, t),
+			r1.x, r1.y, r1.z, Dot(a, t),
+			r2.x, r2.y, r2.z, -Dot(d, s),
+			r3.x, r3.y, r3.z, Dot(c, s)
+		);
+	}
 }
@@ -0,0 +1,35 @@
+/*
+	SIMD feature detection for ewMath.
+	Define EW_NO_SIMD before including any ewMath header to force the scalar paths.
+*/
+
+#pragma once
+
+//EW_SIMD_SSE implies SSE2, which every x86-64 target has
+#if !defined(EW_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define EW_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(EW_SIMD_SSE) && defined(__AVX__)
+#define EW_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+
+//Lets SIMD kernels keep a scalar branch for constant evaluation (C++20).
+//Before C++20 those functions are plain inline and always take the SIMD branch.
+#include <type_traits>
+#if defined(__cpp_lib_is_constant_evaluated)
+#define EW_SIMD_CONSTEXPR constexpr
+#define EW_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+#define EW_SIMD_CONSTEXPR
+#define EW_IS_CONSTANT_EVALUATED() false
+#endif
+
+//Vec4 and Mat4 rows are 16 byte aligned when SIMD is available so loads never split a cache line
+#if defined(EW_SIMD_SSE)
+#define EW_ALIGN16 alignas(16)
+#else
+#define EW_ALIGN16
+#endif
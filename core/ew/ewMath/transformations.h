@@ -4,11 +4,12 @@
 
 #pragma once
 #include "mat4.h"
+#include "mat3.h"
 #include "vec3.h"
 
 namespace ew {
 	//Identity matrix
-	inline ew::Mat4 Identity() {
+	constexpr ew::Mat4 Identity() {
 		return ew::Mat4(
 			1, 0, 0, 0,
 			0, 1, 0, 0,
@@ -17,7 +18,7 @@ namespace ew {
 		);
 	};
 	//Scale on x,y,z axes
-	inline ew::Mat4 Scale(const ew::Vec3& s) {
+	constexpr ew::Mat4 Scale(const ew::Vec3& s) {
 		return ew::Mat4(
 			s.x, 0, 0, 0,
 			0, s.y, 0, 0,
@@ -59,7 +60,7 @@ namespace ew {
 		);
 	};
 	//Translate x,y,z
-	inline ew::Mat4 Translate(const ew::Vec3& t) {
+	constexpr ew::Mat4 Translate(const ew::Vec3& t) {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, t.x,
 			0.0f, 1.0f, 0.0f, t.y,
@@ -69,6 +70,30 @@ namespace ew {
 	
 	};
 
+	/// <summary>
+	/// Closed form of Translate(t) * RotateY(r.y) * RotateX(r.x) * RotateZ(r.z) * Scale(s).
+	/// One sin/cos pair per axis and no matrix products.
+	/// </summary>
+	/// <param name="t">Translation</param>
+	/// <param name="r">Euler angles in radians</param>
+	/// <param name="s">Scale</param>
+	inline ew::Mat4 TRS(const ew::Vec3& t, const ew::Vec3& r, const ew::Vec3& s) {
+		const float cx = cosf(r.x), sx = sinf(r.x);
+		const float cy = cosf(r.y), sy = sinf(r.y);
+		const float cz = cosf(r.z), sz = sinf(r.z);
+		return ew::Mat4(
+			(cy * cz + sy * sx * sz) * s.x, (sy * sx * cz - cy * sz) * s.y, sy * cx * s.z, t.x,
+			cx * sz * s.x, cx * cz * s.y, -sx * s.z, t.y,
+			(cy * sx * sz - sy * cz) * s.x, (sy * sz + cy * sx * cz) * s.y, cy * cx * s.z, t.z,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+
+	//Inverse transpose of the upper 3x3 of model. Transforms normals correctly under non uniform scale.
+	inline ew::Mat3 NormalMatrix(const ew::Mat4& model) {
+		return ew::Transpose(ew::Inverse(ew::Mat3(model)));
+	}
+
 	inline ew::Mat4 LookAt(const ew::Vec3& eyePos, const ew::Vec3& targetPos, const ew::Vec3& up) {
 		ew::Vec3 f = ew::Normalize(eyePos - targetPos);
 		ew::Vec3 r = ew::Normalize(ew::Cross(up, f));
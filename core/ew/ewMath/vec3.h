@@ -9,41 +9,52 @@ namespace ew {
 	struct Vec3 {
 		float x, y, z;
 
-		Vec3() :x(0), y(0), z(0) {};
-		Vec3(float x) :x(x), y(x), z(x) {};
-		Vec3(float x, float y) :x(x), y(y), z(0) {};
-		Vec3(float x, float y, float z) :x(x), y(y), z(z) {};
+		constexpr Vec3() :x(0), y(0), z(0) {};
+		constexpr Vec3(float x) :x(x), y(x), z(x) {};
+		constexpr Vec3(float x, float y) :x(x), y(y), z(0) {};
+		constexpr Vec3(float x, float y, float z) :x(x), y(y), z(z) {};
 
 		//Operator overloads
-		Vec3& operator+=(const Vec3& rhs);
-		Vec3& operator-=(const Vec3& rhs);
-		Vec3& operator*=(float rhs);
-		Vec3& operator/=(float rhs);
-
-		friend Vec3 operator+(Vec3 lhs, const Vec3& rhs);
-		friend Vec3 operator-(Vec3 lhs, const Vec3& rhs);
-		friend Vec3 operator*(Vec3 lhs, float rhs);
-		friend Vec3 operator*(float lhs, Vec3 rhs);
-		friend Vec3 operator/(Vec3 lhs, float rhs);
-		friend Vec3 operator-(const Vec3& rhs);
+		constexpr Vec3& operator+=(const Vec3& rhs);
+		constexpr Vec3& operator-=(const Vec3& rhs);
+		constexpr Vec3& operator*=(float rhs);
+		constexpr Vec3& operator/=(float rhs);
+
+		friend constexpr Vec3 operator+(Vec3 lhs, const Vec3& rhs);
+		friend constexpr Vec3 operator-(Vec3 lhs, const Vec3& rhs);
+		friend constexpr Vec3 operator*(Vec3 lhs, float rhs);
+		friend constexpr Vec3 operator*(float lhs, Vec3 rhs);
+		friend constexpr Vec3 operator/(Vec3 lhs, float rhs);
+		friend constexpr Vec3 operator-(const Vec3& rhs);
+
+		float& operator[](int i);
+		const float& operator[](int i)const;
 	};
+	inline float& Vec3::operator[](int i)
+	{
+		return ((&x)[i]);
+	}
+	inline const float& Vec3::operator[](int i) const
+	{
+		return ((&x)[i]);
+	}
 
 	//Operator overloads
-	inline Vec3& Vec3::operator+=(const Vec3& rhs) {
+	constexpr Vec3& Vec3::operator+=(const Vec3& rhs) {
 		this->x += rhs.x;
 		this->y += rhs.y;
 		this->z += rhs.z;
 		return *this;
 	}
 
-	inline Vec3& Vec3::operator-=(const Vec3& rhs) {
+	constexpr Vec3& Vec3::operator-=(const Vec3& rhs) {
 		this->x -= rhs.x;
 		this->y -= rhs.y;
 		this->z -= rhs.z;
 		return *this;
 	}
 
-	inline Vec3& Vec3::operator*=(float rhs)
+	constexpr Vec3& Vec3::operator*=(float rhs)
 	{
 		this->x *= rhs;
 		this->y *= rhs;
@@ -51,52 +62,52 @@ namespace ew {
 		return *this;
 	}
 
-	inline Vec3& Vec3::operator/=(float rhs)
+	constexpr Vec3& Vec3::operator/=(float rhs)
 	{
 		*this *= (1.0f / rhs);
 		return *this;
 	}
 
-	inline Vec3 operator+(Vec3 lhs, const Vec3& rhs)
+	constexpr Vec3 operator+(Vec3 lhs, const Vec3& rhs)
 	{
 		lhs += rhs;
 		return lhs;
 	}
 
-	inline Vec3 operator-(Vec3 lhs, const Vec3& rhs)
+	constexpr Vec3 operator-(Vec3 lhs, const Vec3& rhs)
 	{
 		lhs -= rhs;
 		return lhs;
 	}
 
-	inline Vec3 operator*(Vec3 lhs, float rhs)
+	constexpr Vec3 operator*(Vec3 lhs, float rhs)
 	{
 		lhs *= rhs;
 		return lhs;
 	}
-	inline Vec3 operator*(float lhs, Vec3 rhs)
+	constexpr Vec3 operator*(float lhs, Vec3 rhs)
 	{
 		rhs *= lhs;
 		return rhs;
 	}
 
-	inline Vec3 operator/(Vec3 lhs, float rhs)
+	constexpr Vec3 operator/(Vec3 lhs, float rhs)
 	{
 		lhs /= rhs;
 		return lhs;
 	}
 
-	inline Vec3 operator-(const Vec3& rhs)
+	constexpr Vec3 operator-(const Vec3& rhs)
 	{
 		return rhs * -1.0f;
 	}
 
 	//Utility functions
-	inline float Dot(const Vec3& a, const Vec3& b) {
+	constexpr float Dot(const Vec3& a, const Vec3& b) {
 		return a.x * b.x + a.y * b.y + a.z * b.z;
 	}
 
-	inline Vec3 Cross(const Vec3& a, const Vec3& b) {
+	constexpr Vec3 Cross(const Vec3& a, const Vec3& b) {
 		return Vec3{
 			a.y * b.z - a.z * b.y,
 			a.z * b.x - a.x * b.z,
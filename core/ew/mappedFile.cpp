@@ -0,0 +1,93 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping) {
+			CloseHandle(file);
+			return false;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!data) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_data = (const unsigned char*)data;
+		m_size = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle((HANDLE)m_mapping);
+		if (m_file)
+			CloseHandle((HANDLE)m_file);
+		m_data = nullptr;
+		m_size = 0;
+		m_mapping = nullptr;
+		m_file = nullptr;
+	}
+#else
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+		int file = ::open(filePath.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0) {
+			::close(file);
+			return false;
+		}
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		//The mapping keeps its own reference to the file
+		::close(file);
+		if (data == MAP_FAILED)
+			return false;
+		m_data = (const unsigned char*)data;
+		m_size = (size_t)info.st_size;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data)
+			munmap((void*)m_data, m_size);
+		m_data = nullptr;
+		m_size = 0;
+	}
+#endif
+}
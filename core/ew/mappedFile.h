@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace ew {
+	/// <summary>
+	/// Read only memory mapping of a whole file. Pages are loaded by the OS on first touch and shared with its file cache,
+	/// so opening a large file costs almost nothing until its contents are read.
+	/// </summary>
+	class MappedFile {
+	public:
+		MappedFile() {};
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// <summary>
+		/// Maps the file, replacing any previous mapping. Returns false if the file can't be opened or is empty.
+		/// </summary>
+		bool open(const std::string& filePath);
+		void close();
+
+		inline bool isOpen()const { return m_data != nullptr; }
+		inline const unsigned char* data()const { return m_data; }
+		inline size_t size()const { return m_size; }
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr; //HANDLE
+		void* m_mapping = nullptr; //HANDLE
+#endif
+	};
+}
@@ -5,70 +5,580 @@
 #include "mesh.h"
 #include "ewMath/ewMath.h"
 #include "external/glad.h"
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
 
 namespace ew {
+	AABB CalculateBounds(const MeshData& meshData)
+	{
+		AABB bounds;
+		for (const Vertex& v : meshData.vertices)
+		{
+			bounds.expand(v.pos);
+		}
+		return bounds;
+	}
+
+	static int PositionSize(PositionFormat format) { return format == PositionFormat::FLOAT32 ? 12 : 8; }
+	static int NormalSize(NormalFormat format) { return format == NormalFormat::FLOAT32 ? 12 : 4; }
+	static int UVSize(UVFormat format) { return format == UVFormat::FLOAT32 ? 8 : 4; }
+
+	int VertexStride(const VertexFormat& format)
+	{
+		return PositionSize(format.position) + NormalSize(format.normal) + UVSize(format.uv);
+	}
+
+	IndexFormat SmallestIndexFormat(int numVertices)
+	{
+		return numVertices <= 0xFFFF ? IndexFormat::UINT16 : IndexFormat::UINT32;
+	}
+
+	int IndexSize(IndexFormat format)
+	{
+		return format == IndexFormat::UINT16 ? 2 : 4;
+	}
+
+	//Narrows indices into out when every vertex index fits in 16 bits, returns the format of the indices to upload
+	static IndexFormat NarrowIndices(const unsigned int* indices, int numIndices, int numVertices, std::vector<uint16_t>& out)
+	{
+		if (SmallestIndexFormat(numVertices) != IndexFormat::UINT16)
+			return IndexFormat::UINT32;
+		out.resize(numIndices);
+		for (int i = 0; i < numIndices; i++)
+		{
+			out[i] = (uint16_t)indices[i];
+		}
+		return IndexFormat::UINT16;
+	}
+
+	//Round to nearest even, flushes values too small for a half to 0
+	static uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, 4);
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		const int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+		if (((bits >> 23) & 0xff) == 0xff) //inf, nan
+			return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+		if (exponent >= 31)
+			return (uint16_t)(sign | 0x7c00);
+		if (exponent <= 0) {
+			if (exponent < -10)
+				return (uint16_t)sign;
+			//Subnormal half
+			mantissa |= 0x800000;
+			const int shift = 14 - exponent;
+			uint32_t half = mantissa >> shift;
+			const uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				half++;
+			return (uint16_t)(sign | half);
+		}
+		uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+		const uint32_t rest = mantissa & 0x1fff;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++; //may carry into the exponent, which rounds up to the next power of two or inf as it should
+		return (uint16_t)(sign | half);
+	}
+
+	static uint16_t ToUnorm16(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return (uint16_t)(value * 65535.0f + 0.5f);
+	}
+
+	static int16_t ToSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return (int16_t)(value * 32767.0f + (value < 0.0f ? -0.5f : 0.5f));
+	}
+
+	//Projects the unit sphere onto an octahedron and unfolds it into the [-1, 1] square
+	static void OctEncode(const ew::Vec3& n, int16_t* out)
+	{
+		const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+		float x = l1 > 0.0f ? n.x / l1 : 0.0f;
+		float y = l1 > 0.0f ? n.y / l1 : 0.0f;
+		if (n.z < 0.0f) {
+			const float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+		out[0] = ToSnorm16(x);
+		out[1] = ToSnorm16(y);
+	}
+
+	//Writes numVertices vertices in format to packed. invScale and positionOffset quantize UNORM16 positions
+	static void PackVertices(const Vertex* vertices, int numVertices, const VertexFormat& format, const ew::Vec3& positionOffset, const ew::Vec3& invScale, uint8_t* packed)
+	{
+		const int stride = VertexStride(format);
+		for (int i = 0; i < numVertices; i++)
+		{
+			const Vertex& v = vertices[i];
+			uint8_t* out = &packed[(size_t)i * stride];
+			if (format.position == PositionFormat::FLOAT32) {
+				memcpy(out, &v.pos, 12);
+			}
+			else {
+				const ew::Vec3 p = (v.pos - positionOffset);
+				const uint16_t q[4] = { ToUnorm16(p.x * invScale.x), ToUnorm16(p.y * invScale.y), ToUnorm16(p.z * invScale.z), 0 };
+				memcpy(out, q, 8);
+			}
+			out += PositionSize(format.position);
+
+			if (format.normal == NormalFormat::FLOAT32) {
+				memcpy(out, &v.normal, 12);
+			}
+			else {
+				int16_t oct[2];
+				OctEncode(v.normal, oct);
+				memcpy(out, oct, 4);
+			}
+			out += NormalSize(format.normal);
+
+			if (format.uv == UVFormat::FLOAT32) {
+				memcpy(out, &v.uv, 8);
+			}
+			else {
+				const uint16_t uv[2] = {
+					format.uv == UVFormat::HALF16 ? FloatToHalf(v.uv.x) : ToUnorm16(v.uv.x),
+					format.uv == UVFormat::HALF16 ? FloatToHalf(v.uv.y) : ToUnorm16(v.uv.y)
+				};
+				memcpy(out, uv, 4);
+			}
+		}
+	}
+
+	PackedMeshData PackMeshData(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds, const VertexFormat& format)
+	{
+		PackedMeshData packed;
+		packed.format = format;
+		packed.stride = VertexStride(format);
+		packed.numVertices = numVertices;
+		packed.vertices.resize((size_t)numVertices * packed.stride);
+		packed.indexFormat = SmallestIndexFormat(numVertices);
+		packed.numIndices = numIndices;
+		packed.indices.resize((size_t)numIndices * IndexSize(packed.indexFormat));
+		if (packed.indexFormat == IndexFormat::UINT16) {
+			uint16_t* out = (uint16_t*)packed.indices.data();
+			for (int i = 0; i < numIndices; i++)
+			{
+				out[i] = (uint16_t)indices[i];
+			}
+		}
+		else if (numIndices > 0) {
+			memcpy(packed.indices.data(), indices, (size_t)numIndices * sizeof(unsigned int));
+		}
+		packed.bounds = bounds;
+
+		ew::Vec3 invScale = ew::Vec3(0.0f);
+		if (format.position == PositionFormat::UNORM16 && numVertices > 0) {
+			packed.positionOffset = bounds.min;
+			packed.positionScale = bounds.max - bounds.min;
+			//A flat axis stores 0 and dequantizes to the offset
+			invScale.x = packed.positionScale.x > 0.0f ? 1.0f / packed.positionScale.x : 0.0f;
+			invScale.y = packed.positionScale.y > 0.0f ? 1.0f / packed.positionScale.y : 0.0f;
+			invScale.z = packed.positionScale.z > 0.0f ? 1.0f / packed.positionScale.z : 0.0f;
+		}
+
+		PackVertices(vertices, numVertices, format, packed.positionOffset, invScale, packed.vertices.data());
+		return packed;
+	}
+
+	PackedMeshData PackMeshData(const MeshData& meshData, const VertexFormat& format)
+	{
+		return PackMeshData(meshData.vertices.data(), (int)meshData.vertices.size(), meshData.indices.data(), (int)meshData.indices.size(), CalculateBounds(meshData), format);
+	}
+
+	void SetVertexAttributes(const VertexFormat& format)
+	{
+		const int stride = VertexStride(format);
+		size_t offset = 0;
+		//Position attribute
+		if (format.position == PositionFormat::FLOAT32)
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const void*)offset);
+		else
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const void*)offset);
+		glEnableVertexAttribArray(0);
+		offset += PositionSize(format.position);
+
+		//Normal attribute
+		if (format.normal == NormalFormat::FLOAT32)
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (const void*)offset);
+		else
+			glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (const void*)offset);
+		glEnableVertexAttribArray(1);
+		offset += NormalSize(format.normal);
+
+		//UV attribute
+		if (format.uv == UVFormat::FLOAT32)
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (const void*)offset);
+		else if (format.uv == UVFormat::HALF16)
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (const void*)offset);
+		else
+			glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const void*)offset);
+		glEnableVertexAttribArray(2);
+	}
+
 	Mesh::Mesh(const MeshData& meshData)
 	{
 		load(meshData);
 	}
+	Mesh::Mesh(const MeshData& meshData, const VertexFormat& format)
+	{
+		load(PackMeshData(meshData, format));
+	}
 	Mesh::~Mesh()
 	{
+		releaseDynamic();
 		glDeleteVertexArrays(1, &m_vao);
 		glDeleteBuffers(1,&m_vbo);
 		glDeleteBuffers(1, &m_ebo);
 	}
 	void Mesh::load(const MeshData& meshData)
+	{
+		load(meshData, CalculateBounds(meshData));
+	}
+	void Mesh::load(const MeshData& meshData, const AABB& bounds)
+	{
+		load(meshData.vertices.data(), (int)meshData.vertices.size(), meshData.indices.data(), (int)meshData.indices.size(), bounds);
+	}
+	void Mesh::load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds)
+	{
+		std::vector<uint16_t> shortIndices;
+		const IndexFormat indexFormat = NarrowIndices(indices, numIndices, numVertices, shortIndices);
+		upload(vertices, numVertices, indexFormat == IndexFormat::UINT16 ? (const void*)shortIndices.data() : (const void*)indices, numIndices, indexFormat,
+			bounds, VertexFormat(), ew::Vec3(1.0f), ew::Vec3(0.0f));
+	}
+	void Mesh::load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds, const VertexFormat& format)
+	{
+		if (format.position == PositionFormat::FLOAT32 && format.normal == NormalFormat::FLOAT32 && format.uv == UVFormat::FLOAT32) {
+			load(vertices, numVertices, indices, numIndices, bounds);
+			return;
+		}
+		load(PackMeshData(vertices, numVertices, indices, numIndices, bounds, format));
+	}
+	void Mesh::load(const PackedMeshData& packed)
+	{
+		upload(packed.vertices.data(), packed.numVertices, packed.indices.data(), packed.numIndices, packed.indexFormat, packed.bounds,
+			packed.format, packed.positionScale, packed.positionOffset);
+	}
+	void Mesh::upload(const void* vertexData, int numVertices, const void* indexData, int numIndices, IndexFormat indexFormat, const AABB& bounds,
+		const VertexFormat& format, const ew::Vec3& positionScale, const ew::Vec3& positionOffset)
+	{
+		releaseDynamic();
+		setup();
+
+		//Attribute formats are set on every load, a mesh can be reloaded with another format
+		SetVertexAttributes(format);
+
+		if (numVertices > 0) {
+			glBufferData(GL_ARRAY_BUFFER, (size_t)VertexStride(format) * numVertices, vertexData, GL_STATIC_DRAW);
+		}
+		if (numIndices > 0) {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)IndexSize(indexFormat) * numIndices, indexData, GL_STATIC_DRAW);
+		}
+		m_numVertices = numVertices;
+		m_numIndices = numIndices;
+		m_bounds = bounds;
+		m_format = format;
+		m_indexFormat = indexFormat;
+		m_positionScale = positionScale;
+		m_positionOffset = positionOffset;
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	//Creates the buffers on first use and binds them
+	void Mesh::setup()
 	{
 		if (!m_initialized) {
 			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
-
 			glGenBuffers(1, &m_vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-
 			glGenBuffers(1, &m_ebo);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
-
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
-
-			//UV attribute
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
-
 			m_initialized = true;
 		}
 
 		glBindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+	}
+	//Immutable storage can't be respecified, so leaving dynamic mode replaces the vertex buffer
+	void Mesh::releaseDynamic()
+	{
+		if (!m_dynamic)
+			return;
+		for (int i = 0; i < DYNAMIC_REGIONS; i++)
+		{
+			if (m_fences[i])
+				glDeleteSync((GLsync)m_fences[i]);
+			m_fences[i] = nullptr;
+		}
+		if (m_mapped) {
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			m_mapped = nullptr;
+		}
+		glDeleteBuffers(1, &m_vbo);
+		glGenBuffers(1, &m_vbo);
+		m_shadow.clear();
+		m_shadow.shrink_to_fit();
+		m_dynamic = false;
+	}
+	void Mesh::loadDynamic(const MeshData& meshData, const VertexFormat& format)
+	{
+		releaseDynamic();
+		setup();
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		VertexFormat dynamicFormat = format;
+		dynamicFormat.position = PositionFormat::FLOAT32;
+		SetVertexAttributes(dynamicFormat);
+		const int numVertices = (int)meshData.vertices.size();
+		const int numIndices = (int)meshData.indices.size();
+		const int stride = VertexStride(dynamicFormat);
+		m_shadow.resize((size_t)numVertices * stride);
+		PackVertices(meshData.vertices.data(), numVertices, dynamicFormat, ew::Vec3(0.0f), ew::Vec3(0.0f), m_shadow.data());
+
+		const size_t ringBytes = m_shadow.size() * DYNAMIC_REGIONS;
+		if (GLAD_GL_VERSION_4_4 && ringBytes > 0) {
+			//Coherent, so writes through the mapping need no flush before the draw that reads them
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, ringBytes, NULL, flags);
+			m_mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, ringBytes, flags);
+			for (int i = 0; i < DYNAMIC_REGIONS; i++)
+			{
+				memcpy(m_mapped + i * m_shadow.size(), m_shadow.data(), m_shadow.size());
+			}
+		}
+		else {
+			glBufferData(GL_ARRAY_BUFFER, ringBytes, NULL, GL_DYNAMIC_DRAW);
+			for (int i = 0; i < DYNAMIC_REGIONS; i++)
+			{
+				glBufferSubData(GL_ARRAY_BUFFER, i * m_shadow.size(), m_shadow.size(), m_shadow.data());
+			}
+		}
+
+		std::vector<uint16_t> shortIndices;
+		const IndexFormat indexFormat = NarrowIndices(meshData.indices.data(), numIndices, numVertices, shortIndices);
+		if (numIndices > 0) {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)IndexSize(indexFormat) * numIndices,
+				indexFormat == IndexFormat::UINT16 ? (const void*)shortIndices.data() : (const void*)meshData.indices.data(), GL_STATIC_DRAW);
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		m_numVertices = numVertices;
+		m_numIndices = numIndices;
+		m_bounds = CalculateBounds(meshData);
+		m_format = dynamicFormat;
+		m_indexFormat = indexFormat;
+		m_positionScale = ew::Vec3(1.0f);
+		m_positionOffset = ew::Vec3(0.0f);
+		m_dynamic = true;
+		m_region = 0;
+		m_regionDrawn = false;
+		for (int i = 0; i < DYNAMIC_REGIONS; i++)
+		{
+			m_dirtyBegin[i] = m_dirtyEnd[i] = 0;
 		}
-		m_numVertices = meshData.vertices.size();
-		m_numIndices = meshData.indices.size();
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
+	void Mesh::updateVertices(int first, const Vertex* vertices, int count)
+	{
+		if (!m_dynamic) {
+			printf("Mesh::updateVertices needs a mesh loaded with loadDynamic\n");
+			return;
+		}
+		if (first < 0 || count < 0 || first + count > m_numVertices) {
+			printf("Mesh::updateVertices range %d + %d is outside the %d vertices\n", first, count, m_numVertices);
+			return;
+		}
+		if (count == 0)
+			return;
+		const int stride = VertexStride(m_format);
+		PackVertices(vertices, count, m_format, ew::Vec3(0.0f), ew::Vec3(0.0f), &m_shadow[(size_t)first * stride]);
+		//Plain compares instead of AABB::expand, fminf/fmaxf are library calls that cost more than the packing
+		ew::Vec3 boundsMin = m_bounds.min, boundsMax = m_bounds.max;
+		for (int i = 0; i < count; i++)
+		{
+			const ew::Vec3& p = vertices[i].pos;
+			boundsMin.x = p.x < boundsMin.x ? p.x : boundsMin.x;
+			boundsMin.y = p.y < boundsMin.y ? p.y : boundsMin.y;
+			boundsMin.z = p.z < boundsMin.z ? p.z : boundsMin.z;
+			boundsMax.x = p.x > boundsMax.x ? p.x : boundsMax.x;
+			boundsMax.y = p.y > boundsMax.y ? p.y : boundsMax.y;
+			boundsMax.z = p.z > boundsMax.z ? p.z : boundsMax.z;
+		}
+		m_bounds.min = boundsMin;
+		m_bounds.max = boundsMax;
+
+		//Every region is now behind on this range until it is written
+		for (int i = 0; i < DYNAMIC_REGIONS; i++)
+		{
+			if (m_dirtyBegin[i] == m_dirtyEnd[i]) {
+				m_dirtyBegin[i] = first;
+				m_dirtyEnd[i] = first + count;
+			}
+			else {
+				m_dirtyBegin[i] = first < m_dirtyBegin[i] ? first : m_dirtyBegin[i];
+				m_dirtyEnd[i] = first + count > m_dirtyEnd[i] ? first + count : m_dirtyEnd[i];
+			}
+		}
+
+		//Updates before the next draw keep writing the same region
+		if (m_regionDrawn) {
+			m_region = (m_region + 1) % DYNAMIC_REGIONS;
+			m_regionDrawn = false;
+			//Only blocks if the GPU is more than DYNAMIC_REGIONS - 1 draws behind
+			if (m_fences[m_region]) {
+				GLsync fence = (GLsync)m_fences[m_region];
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+				glDeleteSync(fence);
+				m_fences[m_region] = nullptr;
+			}
+		}
+		writeRegion();
+	}
+	//Brings m_region up to date with the shadow copy
+	void Mesh::writeRegion()
+	{
+		const size_t stride = VertexStride(m_format);
+		const size_t regionOffset = (size_t)m_region * m_numVertices * stride;
+		const size_t begin = m_dirtyBegin[m_region] * stride;
+		const size_t bytes = (m_dirtyEnd[m_region] - m_dirtyBegin[m_region]) * stride;
+		if (m_mapped) {
+			memcpy(m_mapped + regionOffset + begin, &m_shadow[begin], bytes);
+		}
+		else {
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glBufferSubData(GL_ARRAY_BUFFER, regionOffset + begin, bytes, &m_shadow[begin]);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		m_dirtyBegin[m_region] = m_dirtyEnd[m_region] = 0;
+	}
+	//Restarts at the largest value of the index type, so PRIMITIVE_RESTART_INDEX works narrowed to UINT16 as well
+	static void SetPrimitiveRestart(bool enabled, GLenum indexType)
+	{
+		if (GLAD_GL_VERSION_4_3) {
+			if (enabled)
+				glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+			else
+				glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+		}
+		else if (enabled) {
+			glEnable(GL_PRIMITIVE_RESTART);
+			glPrimitiveRestartIndex(indexType == GL_UNSIGNED_SHORT ? 0xFFFF : PRIMITIVE_RESTART_INDEX);
+		}
+		else {
+			glDisable(GL_PRIMITIVE_RESTART);
+		}
+	}
+
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
 		glBindVertexArray(m_vao);
-		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+		submit(drawMode, 0);
+	}
+
+	//Attribute locations of InstanceData, the model matrix takes one per column
+	static const int INSTANCE_MODEL_LOCATION = 5;
+	static const int INSTANCE_DATA_LOCATION = 9;
+
+	void Mesh::drawInstanced(const InstanceBuffer& instances, ew::DrawMode drawMode) const
+	{
+		if (instances.size() == 0)
+			return;
+		glBindVertexArray(m_vao);
+		//Instance attributes are pointed at the buffer for this draw only, so one buffer works with every mesh
+		instances.bindAttributes();
+
+		submit(drawMode, instances.size());
+
+		//Disabled again, so plain draws of this mesh read the constant attribute values instead of a buffer that may be gone
+		for (int location = INSTANCE_MODEL_LOCATION; location <= INSTANCE_DATA_LOCATION; location++)
+		{
+			glDisableVertexAttribArray(location);
+		}
+	}
+
+	void Mesh::submit(ew::DrawMode drawMode, int instanceCount) const
+	{
+		//Decode constants for the vertex shader, see VertexFormat. Constant attributes aren't part of the VAO, so they are set for every draw
+		glVertexAttrib4f(3, m_positionScale.x, m_positionScale.y, m_positionScale.z, m_format.normal == NormalFormat::OCT16 ? 1.0f : 0.0f);
+		glVertexAttrib4f(4, m_positionOffset.x, m_positionOffset.y, m_positionOffset.z, 0.0f);
+		const GLenum indexType = m_indexFormat == IndexFormat::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		const GLenum primitive = drawMode == DrawMode::TRIANGLE_STRIP ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+		//Only on for strip draws, other meshes may use every index value
+		if (drawMode == DrawMode::TRIANGLE_STRIP)
+			SetPrimitiveRestart(true, indexType);
+		//The current region of a dynamic mesh's ring, the same indices offset by its first vertex
+		const int baseVertex = m_dynamic ? m_region * m_numVertices : 0;
+		if (drawMode == DrawMode::POINTS) {
+			if (instanceCount > 0)
+				glDrawArraysInstanced(GL_POINTS, baseVertex, m_numVertices, instanceCount);
+			else
+				glDrawArrays(GL_POINTS, baseVertex, m_numVertices);
+		}
+		else if (!m_dynamic) {
+			if (instanceCount > 0)
+				glDrawElementsInstanced(primitive, m_numIndices, indexType, NULL, instanceCount);
+			else
+				glDrawElements(primitive, m_numIndices, indexType, NULL);
 		}
 		else {
-			glDrawArrays(GL_POINTS, 0, m_numVertices);
+			if (instanceCount > 0)
+				glDrawElementsInstancedBaseVertex(primitive, m_numIndices, indexType, NULL, instanceCount, baseVertex);
+			else
+				glDrawElementsBaseVertex(primitive, m_numIndices, indexType, NULL, baseVertex);
+		}
+		if (m_dynamic) {
+			if (m_fences[m_region])
+				glDeleteSync((GLsync)m_fences[m_region]);
+			m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			m_regionDrawn = true;
+		}
+		if (drawMode == DrawMode::TRIANGLE_STRIP)
+			SetPrimitiveRestart(false, indexType);
+	}
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		if (m_vbo)
+			glDeleteBuffers(1, &m_vbo);
+	}
+
+	void InstanceBuffer::bindAttributes(size_t firstInstance) const
+	{
+		bind();
+		const GLsizei stride = sizeof(InstanceData);
+		const size_t offset = firstInstance * sizeof(InstanceData);
+		for (int column = 0; column < 4; column++)
+		{
+			const int location = INSTANCE_MODEL_LOCATION + column;
+			glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(offset + offsetof(InstanceData, model) + column * sizeof(ew::Vec4)));
+			glVertexAttribDivisor(location, 1);
+			glEnableVertexAttribArray(location);
+		}
+		glVertexAttribPointer(INSTANCE_DATA_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(offset + offsetof(InstanceData, data)));
+		glVertexAttribDivisor(INSTANCE_DATA_LOCATION, 1);
+		glEnableVertexAttribArray(INSTANCE_DATA_LOCATION);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void InstanceBuffer::bind() const
+	{
+		if (!m_vbo)
+			glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		if (m_dirty) {
+			//Respecified as a whole, so the driver can hand out new storage while draws still read the old instances
+			glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(InstanceData), m_instances.data(), GL_STREAM_DRAW);
+			m_dirty = false;
 		}
-		
 	}
-}
\ No newline at end of file
+}
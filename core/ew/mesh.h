@@ -4,6 +4,10 @@
 
 #pragma once
 #include "ewMath/ewMath.h"
+#include "ewMath/bounds.h"
+#include "transform.h"
+#include <vector>
+#include <stdint.h>
 
 namespace ew {
 	struct Vertex {
@@ -17,26 +21,183 @@ namespace ew {
 		std::vector<unsigned int> indices;
 	};
 
+	//Object space bounds of all vertex positions
+	AABB CalculateBounds(const MeshData& meshData);
+
+	enum class PositionFormat {
+		FLOAT32 = 0, //12 bytes
+		UNORM16 = 1 //8 bytes, 16 bits per axis across the mesh bounds. Dequantized by the vertex shader with the mesh's scale and offset
+	};
+	enum class NormalFormat {
+		FLOAT32 = 0, //12 bytes
+		OCT16 = 1 //4 bytes, octahedral encoding in 2 snorm16. Decoded by the vertex shader
+	};
+	enum class UVFormat {
+		FLOAT32 = 0, //8 bytes
+		HALF16 = 1, //4 bytes, any range
+		UNORM16 = 2 //4 bytes, UVs must be in [0, 1]
+	};
+
+	/// <summary>
+	/// GPU vertex layout of a Mesh. The default is ew::Vertex as is (32 bytes), the most compact is 16 bytes.
+	/// Anything but FLOAT32 positions and normals needs a vertex shader that decodes them:
+	/// layout(location = 3) in vec4 vPositionScale; //xyz: position scale, w: 1 for OCT16 normals
+	/// layout(location = 4) in vec3 vPositionOffset;
+	/// Mesh::draw sets both as constant vertex attributes, so one shader works with every format.
+	/// </summary>
+	struct VertexFormat {
+		PositionFormat position = PositionFormat::FLOAT32;
+		NormalFormat normal = NormalFormat::FLOAT32;
+		UVFormat uv = UVFormat::FLOAT32;
+	};
+	//Byte size of one vertex in format, attributes padded to 4 bytes
+	int VertexStride(const VertexFormat& format);
+	//Points attributes 0 to 2 of the bound VAO at vertices of format in the bound GL_ARRAY_BUFFER
+	void SetVertexAttributes(const VertexFormat& format);
+
+	enum class IndexFormat {
+		UINT32 = 0,
+		UINT16 = 1 //meshes with at most 65535 vertices. 0xFFFF is never a vertex index, it stays free for primitive restart
+	};
+	//UINT16 whenever every vertex index fits, halving index memory and bandwidth
+	IndexFormat SmallestIndexFormat(int numVertices);
+	int IndexSize(IndexFormat format);
+
+	/// <summary>
+	/// Vertices converted to a VertexFormat, ready for upload. Can be built on a worker thread.
+	/// </summary>
+	struct PackedMeshData {
+		VertexFormat format;
+		int stride = 0;
+		int numVertices = 0;
+		std::vector<uint8_t> vertices; //numVertices * stride bytes
+		IndexFormat indexFormat = IndexFormat::UINT32;
+		int numIndices = 0;
+		std::vector<uint8_t> indices; //numIndices * IndexSize(indexFormat) bytes
+		AABB bounds;
+		ew::Vec3 positionScale = ew::Vec3(1.0f); //object position = stored * scale + offset
+		ew::Vec3 positionOffset = ew::Vec3(0.0f);
+	};
+	PackedMeshData PackMeshData(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds, const VertexFormat& format);
+	PackedMeshData PackMeshData(const MeshData& meshData, const VertexFormat& format);
+
+	//Ends one strip and starts the next in TRIANGLE_STRIP index buffers. UINT16 index buffers store it as 0xFFFF
+	const unsigned int PRIMITIVE_RESTART_INDEX = 0xFFFFFFFF;
+
 	enum class DrawMode {
 		TRIANGLES = 0,
-		POINTS = 1
+		POINTS = 1,
+		TRIANGLE_STRIP = 2 //the indices are strips separated by PRIMITIVE_RESTART_INDEX, e.g. from StripifyMesh
+	};
+
+	/// <summary>
+	/// Per instance vertex attributes of Mesh::drawInstanced, read by the vertex shader as
+	/// layout(location = 5) in mat4 iModel; //locations 5 to 8
+	/// layout(location = 9) in vec4 iData; //anything per instance, e.g. a color
+	/// Shaders that need a normal matrix derive it from iModel, e.g. mat3(iModel) for uniform scales.
+	/// </summary>
+	struct InstanceData {
+		ew::Mat4 model;
+		ew::Vec4 data = ew::Vec4(1.0f);
+	};
+
+	/// <summary>
+	/// CPU list of instances for Mesh::drawInstanced, in one GPU buffer uploaded by the first draw after a change.
+	/// Fill it once for static instances, or clear and refill it every frame e.g. with only the visible ones.
+	/// One buffer can be drawn with any number of meshes.
+	/// </summary>
+	class InstanceBuffer {
+	public:
+		InstanceBuffer() {};
+		~InstanceBuffer();
+		inline void clear() { m_instances.clear(); m_dirty = true; }
+		inline void reserve(int count) { m_instances.reserve(count); }
+		inline void add(const InstanceData& instance) { m_instances.push_back(instance); m_dirty = true; }
+		inline void add(const ew::Mat4& model, const ew::Vec4& data = ew::Vec4(1.0f)) { add(InstanceData{ model, data }); }
+		inline void add(const Transform& transform, const ew::Vec4& data = ew::Vec4(1.0f)) { add(InstanceData{ transform.getModelMatrix(), data }); }
+		//Writable in place, e.g. to animate instances. Uploads all of them again on the next draw
+		inline InstanceData& operator[](int i) { m_dirty = true; return m_instances[i]; }
+		inline const InstanceData& operator[](int i)const { return m_instances[i]; }
+		inline int size()const { return (int)m_instances.size(); }
+		//Binds the GPU copy to GL_ARRAY_BUFFER, uploading the instances first if they changed
+		void bind()const;
+		//Points instance attributes 5 to 9 of the bound VAO at the GPU copy, starting at firstInstance
+		void bindAttributes(size_t firstInstance = 0)const;
+	private:
+		std::vector<InstanceData> m_instances;
+		mutable unsigned int m_vbo = 0;
+		mutable bool m_dirty = true;
 	};
 
 	class Mesh {
 	public:
 		Mesh() {};
 		Mesh(const MeshData& meshData);
+		Mesh(const MeshData& meshData, const VertexFormat& format);
 		~Mesh();
 		void load(const MeshData& meshData);
+		//Skips CalculateBounds when the bounds are already known, e.g. computed on a worker thread
+		void load(const MeshData& meshData, const AABB& bounds);
+		//Uploads raw arrays, e.g. straight from a memory mapped file without copying them into a MeshData first
+		void load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds);
+		//Converts to format on the calling thread before uploading
+		void load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const AABB& bounds, const VertexFormat& format);
+		void load(const PackedMeshData& packed);
+		/// <summary>
+		/// Dynamic mode, for vertices rewritten from the CPU, e.g. animation or land reseeded at the same size.
+		/// Vertices live in a ring of DYNAMIC_REGIONS copies in one buffer. Every draw fences the copy it read and
+		/// updates after a draw go to the next copy, so the GPU is never waited on or reallocated while it still reads.
+		/// Uses persistently mapped immutable storage on GL 4.4 and glBufferSubData before that.
+		/// Indices stay fixed. Positions are never quantized, UNORM16 positions are uploaded as FLOAT32.
+		/// </summary>
+		void loadDynamic(const MeshData& meshData, const VertexFormat& format = VertexFormat());
+		//Rewrites vertices [first, first + count) of a dynamic mesh and grows the bounds to contain them
+		void updateVertices(int first, const Vertex* vertices, int count);
+		inline bool isDynamic()const { return m_dynamic; }
+		//For when updateVertices moved vertices inwards and the grown bounds are too loose
+		inline void setBounds(const AABB& bounds) { m_bounds = bounds; }
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		//Draws every instance in one draw call. The vertex shader reads InstanceData from locations 5 to 9
+		void drawInstanced(const InstanceBuffer& instances, DrawMode drawMode = DrawMode::TRIANGLES)const;
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		inline const VertexFormat& getVertexFormat()const { return m_format; }
+		//Chosen on load from the vertex count
+		inline IndexFormat getIndexFormat()const { return m_indexFormat; }
+		//Vertex and index buffer sizes
+		inline size_t getGpuBytes()const { return (size_t)m_numVertices * VertexStride(m_format) * (m_dynamic ? DYNAMIC_REGIONS : 1) + (size_t)m_numIndices * IndexSize(m_indexFormat); }
+		//Object space bounds, computed on load. Use with TransformAABB and IsVisible for culling.
+		inline const AABB& getBounds()const { return m_bounds; }
+		//Copies of the vertices kept by dynamic meshes, one being written while the GPU may still read the others
+		static const int DYNAMIC_REGIONS = 3;
 	private:
+		void setup();
+		void releaseDynamic();
+		void writeRegion();
+		//Draws instanceCount instances with the instanced calls, or a plain draw if it is 0
+		void submit(DrawMode drawMode, int instanceCount)const;
+		void upload(const void* vertexData, int numVertices, const void* indexData, int numIndices, IndexFormat indexFormat, const AABB& bounds,
+			const VertexFormat& format, const ew::Vec3& positionScale, const ew::Vec3& positionOffset);
+
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
 		int m_numVertices = 0;
 		int m_numIndices = 0;
+		AABB m_bounds;
+		VertexFormat m_format;
+		IndexFormat m_indexFormat = IndexFormat::UINT32;
+		ew::Vec3 m_positionScale = ew::Vec3(1.0f);
+		ew::Vec3 m_positionOffset = ew::Vec3(0.0f);
+
+		bool m_dynamic = false;
+		unsigned char* m_mapped = nullptr; //persistent mapping of the whole ring, null before GL 4.4
+		std::vector<uint8_t> m_shadow; //latest packed vertices, the source for regions that missed updates
+		int m_dirtyBegin[DYNAMIC_REGIONS] = {}; //vertices each region is behind on
+		int m_dirtyEnd[DYNAMIC_REGIONS] = {};
+		int m_region = 0; //region drawn from and written to
+		mutable bool m_regionDrawn = false; //the next update has to move on to another region
+		mutable void* m_fences[DYNAMIC_REGIONS] = {}; //GLsync of the last draw from each region
 	};
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "meshArena.h"
+#include "external/glad.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
+
+namespace ew {
+	void MeshArena::FreeList::reset(int offset, int capacity)
+	{
+		ranges.clear();
+		if (offset < capacity)
+			ranges.push_back({ offset, capacity - offset });
+	}
+
+	int MeshArena::FreeList::allocate(int count)
+	{
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			if (ranges[i].count < count)
+				continue;
+			const int offset = ranges[i].offset;
+			ranges[i].offset += count;
+			ranges[i].count -= count;
+			if (ranges[i].count == 0)
+				ranges.erase(ranges.begin() + i);
+			return offset;
+		}
+		return -1;
+	}
+
+	void MeshArena::FreeList::release(int offset, int count)
+	{
+		auto next = std::lower_bound(ranges.begin(), ranges.end(), offset, [](const Range& range, int offset) { return range.offset < offset; });
+		//Merged into the free ranges on either side when they touch
+		const bool mergePrevious = next != ranges.begin() && (next - 1)->offset + (next - 1)->count == offset;
+		const bool mergeNext = next != ranges.end() && offset + count == next->offset;
+		if (mergePrevious && mergeNext) {
+			(next - 1)->count += count + next->count;
+			ranges.erase(next);
+		}
+		else if (mergePrevious) {
+			(next - 1)->count += count;
+		}
+		else if (mergeNext) {
+			next->offset = offset;
+			next->count += count;
+		}
+		else {
+			ranges.insert(next, { offset, count });
+		}
+	}
+
+	int MeshArena::FreeList::largest() const
+	{
+		int largest = 0;
+		for (const Range& range : ranges)
+		{
+			largest = std::max(largest, range.count);
+		}
+		return largest;
+	}
+
+	MeshArena::MeshArena(const VertexFormat& format, IndexFormat indexFormat, int vertexCapacity, int indexCapacity)
+		:m_format(format), m_indexFormat(indexFormat), m_vertexCapacity(std::max(vertexCapacity, 1)), m_indexCapacity(std::max(indexCapacity, 3))
+	{
+		m_format.position = PositionFormat::FLOAT32;
+		m_freeVertices.reset(0, m_vertexCapacity);
+		m_freeIndices.reset(0, m_indexCapacity);
+	}
+
+	MeshArena::~MeshArena()
+	{
+		if (!m_vao)
+			return;
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		glDeleteBuffers(1, &m_indirect);
+	}
+
+	//Creates the VAO and buffers on first use
+	void MeshArena::setup()
+	{
+		if (m_vao)
+			return;
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vbo);
+		glGenBuffers(1, &m_ebo);
+		glGenBuffers(1, &m_indirect);
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferData(GL_ARRAY_BUFFER, (size_t)m_vertexCapacity * VertexStride(m_format), NULL, GL_STATIC_DRAW);
+		SetVertexAttributes(m_format);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)m_indexCapacity * IndexSize(m_indexFormat), NULL, GL_STATIC_DRAW);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	int MeshArena::add(const MeshData& meshData)
+	{
+		const int numVertices = (int)meshData.vertices.size();
+		const int numIndices = (int)meshData.indices.size();
+		if (numIndices < 3 || numVertices == 0) {
+			printf("MeshArena: mesh has no triangles\n");
+			return -1;
+		}
+		if (m_indexFormat == IndexFormat::UINT16 && numVertices > 0xFFFF) {
+			printf("MeshArena: %d vertices don't fit 16 bit indices\n", numVertices);
+			return -1;
+		}
+		setup();
+
+		//Defragmenting is enough when the free space is only split up, otherwise the buffer that is out of space grows
+		if (m_freeVertices.largest() < numVertices || m_freeIndices.largest() < numIndices) {
+			const bool vertexSpace = m_verticesUsed + numVertices <= (size_t)m_vertexCapacity;
+			const bool indexSpace = m_indicesUsed + numIndices <= (size_t)m_indexCapacity;
+			if (vertexSpace && indexSpace) {
+				relocate(m_vertexCapacity, m_indexCapacity);
+				m_numDefragments++;
+			}
+			else {
+				relocate(vertexSpace ? m_vertexCapacity : (int)std::max(m_verticesUsed + numVertices, (size_t)m_vertexCapacity * 2),
+					indexSpace ? m_indexCapacity : (int)std::max(m_indicesUsed + numIndices, (size_t)m_indexCapacity * 2));
+				m_numGrows++;
+			}
+		}
+		Allocation allocation;
+		allocation.live = true;
+		allocation.firstVertex = m_freeVertices.allocate(numVertices);
+		allocation.numVertices = numVertices;
+		allocation.firstIndex = m_freeIndices.allocate(numIndices);
+		allocation.numIndices = numIndices;
+		allocation.bounds = CalculateBounds(meshData);
+
+		//Uploaded through GL_COPY_WRITE_BUFFER, binding GL_ELEMENT_ARRAY_BUFFER would change whichever VAO is bound
+		const int stride = VertexStride(m_format);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+		if (m_format.normal == NormalFormat::FLOAT32 && m_format.uv == UVFormat::FLOAT32) {
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)allocation.firstVertex * stride, (size_t)numVertices * stride, meshData.vertices.data());
+		}
+		else {
+			PackedMeshData packed = PackMeshData(meshData.vertices.data(), numVertices, nullptr, 0, allocation.bounds, m_format);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)allocation.firstVertex * stride, packed.vertices.size(), packed.vertices.data());
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+		if (m_indexFormat == IndexFormat::UINT16) {
+			std::vector<uint16_t> shortIndices(meshData.indices.begin(), meshData.indices.end());
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)allocation.firstIndex * 2, (size_t)numIndices * 2, shortIndices.data());
+		}
+		else {
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)allocation.firstIndex * 4, (size_t)numIndices * 4, meshData.indices.data());
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		int id;
+		if (!m_freeIds.empty()) {
+			id = m_freeIds.back();
+			m_freeIds.pop_back();
+			m_meshes[id] = allocation;
+		}
+		else {
+			id = (int)m_meshes.size();
+			m_meshes.push_back(allocation);
+		}
+		m_numMeshes++;
+		m_verticesUsed += numVertices;
+		m_indicesUsed += numIndices;
+		return id;
+	}
+
+	void MeshArena::remove(int id)
+	{
+		Allocation& allocation = m_meshes[id];
+		if (!allocation.live)
+			return;
+		m_freeVertices.release(allocation.firstVertex, allocation.numVertices);
+		m_freeIndices.release(allocation.firstIndex, allocation.numIndices);
+		m_verticesUsed -= allocation.numVertices;
+		m_indicesUsed -= allocation.numIndices;
+		m_numMeshes--;
+		allocation.live = false;
+		m_freeIds.push_back(id);
+	}
+
+	void MeshArena::defragment()
+	{
+		if (!m_vao || (m_freeVertices.ranges.size() <= 1 && m_freeIndices.ranges.size() <= 1))
+			return;
+		relocate(m_vertexCapacity, m_indexCapacity);
+		m_numDefragments++;
+	}
+
+	void MeshArena::relocate(int vertexCapacity, int indexCapacity)
+	{
+		const int stride = VertexStride(m_format);
+		const int indexSize = IndexSize(m_indexFormat);
+		unsigned int buffers[2];
+		glGenBuffers(2, buffers);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+		glBufferData(GL_COPY_WRITE_BUFFER, (size_t)vertexCapacity * stride, NULL, GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+		glBufferData(GL_COPY_WRITE_BUFFER, (size_t)indexCapacity * indexSize, NULL, GL_STATIC_DRAW);
+
+		//Meshes keep their order in each buffer. Indices are relative to the first vertex, they are copied as they are
+		std::vector<int> order;
+		order.reserve(m_numMeshes);
+		for (int id = 0; id < (int)m_meshes.size(); id++)
+		{
+			if (m_meshes[id].live)
+				order.push_back(id);
+		}
+		std::sort(order.begin(), order.end(), [this](int a, int b) { return m_meshes[a].firstVertex < m_meshes[b].firstVertex; });
+		int nextVertex = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+		for (int id : order)
+		{
+			Allocation& allocation = m_meshes[id];
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (size_t)allocation.firstVertex * stride, (size_t)nextVertex * stride, (size_t)allocation.numVertices * stride);
+			allocation.firstVertex = nextVertex;
+			nextVertex += allocation.numVertices;
+		}
+		std::sort(order.begin(), order.end(), [this](int a, int b) { return m_meshes[a].firstIndex < m_meshes[b].firstIndex; });
+		int nextIndex = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, m_ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+		for (int id : order)
+		{
+			Allocation& allocation = m_meshes[id];
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (size_t)allocation.firstIndex * indexSize, (size_t)nextIndex * indexSize, (size_t)allocation.numIndices * indexSize);
+			allocation.firstIndex = nextIndex;
+			nextIndex += allocation.numIndices;
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		m_vbo = buffers[0];
+		m_ebo = buffers[1];
+		m_vertexCapacity = vertexCapacity;
+		m_indexCapacity = indexCapacity;
+		m_freeVertices.reset(nextVertex, vertexCapacity);
+		m_freeIndices.reset(nextIndex, indexCapacity);
+
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		SetVertexAttributes(m_format);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void MeshArena::queue(int id, const InstanceData& instance)
+	{
+		if (!m_queue.empty() && m_queue.back().id == id) {
+			m_queue.back().numInstances++;
+		}
+		else {
+			m_queue.push_back({ id, m_instances.size(), 1 });
+		}
+		m_instances.add(instance);
+	}
+
+	void MeshArena::drawQueued()
+	{
+		m_lastCommands = (int)m_queue.size();
+		m_lastInstances = m_instances.size();
+		if (m_queue.empty())
+			return;
+		//Commands are built at draw time, so meshes moved by adds since they were queued are drawn from where they are now
+		std::vector<IndirectCommand>& commands = m_commands;
+		commands.resize(m_queue.size());
+		for (size_t i = 0; i < m_queue.size(); i++)
+		{
+			const Allocation& allocation = m_meshes[m_queue[i].id];
+			commands[i].count = allocation.numIndices;
+			commands[i].instanceCount = m_queue[i].numInstances;
+			commands[i].firstIndex = allocation.firstIndex;
+			commands[i].baseVertex = allocation.firstVertex;
+			commands[i].baseInstance = m_queue[i].firstInstance;
+		}
+
+		glBindVertexArray(m_vao);
+		//Positions are never quantized, only the OCT16 flag of the decode constants matters
+		glVertexAttrib4f(3, 1.0f, 1.0f, 1.0f, m_format.normal == NormalFormat::OCT16 ? 1.0f : 0.0f);
+		glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);
+		const GLenum indexType = m_indexFormat == IndexFormat::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		if (GLAD_GL_VERSION_4_3) {
+			//baseInstance selects each command's first InstanceData
+			m_instances.bindAttributes();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(IndirectCommand), commands.data(), GL_STREAM_DRAW);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, NULL, (GLsizei)commands.size(), 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+		else {
+			//Without base instances, the instance attributes are pointed at each command's first instance instead
+			for (const IndirectCommand& command : commands)
+			{
+				m_instances.bindAttributes(command.baseInstance);
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, indexType, (const void*)((size_t)command.firstIndex * IndexSize(m_indexFormat)),
+					command.instanceCount, command.baseVertex);
+			}
+		}
+		glBindVertexArray(0);
+		m_queue.clear();
+		m_instances.clear();
+	}
+
+	MeshArenaStats MeshArena::getStats() const
+	{
+		const size_t stride = VertexStride(m_format);
+		const size_t indexSize = IndexSize(m_indexFormat);
+		MeshArenaStats stats;
+		stats.numMeshes = m_numMeshes;
+		stats.vertexBytesUsed = m_verticesUsed * stride;
+		stats.vertexBytesCapacity = (size_t)m_vertexCapacity * stride;
+		stats.indexBytesUsed = m_indicesUsed * indexSize;
+		stats.indexBytesCapacity = (size_t)m_indexCapacity * indexSize;
+		stats.vertexFreeBlocks = (int)m_freeVertices.ranges.size();
+		stats.indexFreeBlocks = (int)m_freeIndices.ranges.size();
+		stats.largestFreeVertexBytes = (size_t)m_freeVertices.largest() * stride;
+		stats.largestFreeIndexBytes = (size_t)m_freeIndices.largest() * indexSize;
+		stats.numDefragments = m_numDefragments;
+		stats.numGrows = m_numGrows;
+		stats.numCommands = m_lastCommands;
+		stats.numInstances = m_lastInstances;
+		return stats;
+	}
+}
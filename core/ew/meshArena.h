@@ -0,0 +1,121 @@
+#pragma once
+#include "mesh.h"
+#include <vector>
+#include <stdint.h>
+
+namespace ew {
+	struct MeshArenaStats {
+		int numMeshes = 0;
+		size_t vertexBytesUsed = 0;
+		size_t vertexBytesCapacity = 0;
+		size_t indexBytesUsed = 0;
+		size_t indexBytesCapacity = 0;
+		int vertexFreeBlocks = 0; //1 when compact, more when removed meshes left holes
+		int indexFreeBlocks = 0;
+		size_t largestFreeVertexBytes = 0;
+		size_t largestFreeIndexBytes = 0;
+		int numDefragments = 0; //relocations that kept the capacity
+		int numGrows = 0; //relocations into bigger buffers
+		int numCommands = 0; //indirect draw commands of the last drawQueued
+		int numInstances = 0; //instances drawn by the last drawQueued
+	};
+
+	/// <summary>
+	/// Many meshes suballocated from one vertex buffer and one index buffer behind a single VAO, drawn together with one glMultiDrawElementsIndirect.
+	/// Ranges are allocated first fit from free lists sorted by offset, and neighbouring free ranges merge when meshes are removed.
+	/// A mesh that doesn't fit defragments the arena if the free space is enough and grows it otherwise, both by copying the live meshes into new buffers on the GPU.
+	/// Every mesh has the arena's VertexFormat. Positions are never quantized, UNORM16 positions are stored as FLOAT32, since the dequantize constants are per draw.
+	/// Indices are relative to each mesh's first vertex, so UINT16 arenas take any number of meshes of up to 65535 vertices each.
+	/// Meshes are triangle lists. Per draw data is InstanceData, read by the vertex shader as for Mesh::drawInstanced.
+	/// </summary>
+	class MeshArena {
+	public:
+		//Capacities are in vertices and indices, and double whenever they run out
+		MeshArena(const VertexFormat& format = VertexFormat(), IndexFormat indexFormat = IndexFormat::UINT32, int vertexCapacity = 1 << 16, int indexCapacity = 1 << 18);
+		~MeshArena();
+		MeshArena(const MeshArena&) = delete;
+		MeshArena& operator=(const MeshArena&) = delete;
+
+		//Uploads meshData into free space. Returns its id, or -1 if it has no triangles or too many vertices for UINT16 indices
+		int add(const MeshData& meshData);
+		//Frees the mesh's ranges for later adds. Its id is given to a later add
+		void remove(int id);
+		//Moves every mesh to the start of the buffers, leaving one free range at the end of each
+		void defragment();
+		inline const AABB& getBounds(int id)const { return m_meshes[id].bounds; }
+		inline int getNumIndices(int id)const { return m_meshes[id].numIndices; }
+
+		//Queues one instance of mesh id for drawQueued, e.g. for every visible object. Consecutive instances of one mesh share a draw command
+		void queue(int id, const InstanceData& instance);
+		inline void queue(int id, const Transform& transform, const ew::Vec4& data = ew::Vec4(1.0f)) { queue(id, InstanceData{ transform.getModelMatrix(), data }); }
+		//Draws everything queued since the last call and clears the queue.
+		//One glMultiDrawElementsIndirect on GL 4.3, one draw per command before that
+		void drawQueued();
+
+		MeshArenaStats getStats()const;
+	private:
+		struct Range {
+			int offset;
+			int count;
+		};
+		//Free ranges sorted by offset, never touching each other
+		struct FreeList {
+			std::vector<Range> ranges;
+			void reset(int offset, int capacity);
+			//First fit, -1 if no range is large enough
+			int allocate(int count);
+			void release(int offset, int count);
+			int largest()const;
+		};
+		struct Allocation {
+			bool live = false;
+			int firstVertex = 0;
+			int numVertices = 0;
+			int firstIndex = 0;
+			int numIndices = 0;
+			AABB bounds;
+		};
+		//Layout read by glMultiDrawElementsIndirect
+		struct IndirectCommand {
+			uint32_t count;
+			uint32_t instanceCount;
+			uint32_t firstIndex;
+			int32_t baseVertex;
+			uint32_t baseInstance;
+		};
+		struct QueuedDraw {
+			int id;
+			int firstInstance;
+			int numInstances;
+		};
+
+		void setup();
+		//Copies every live mesh to the start of new buffers of the given capacities
+		void relocate(int vertexCapacity, int indexCapacity);
+
+		VertexFormat m_format;
+		IndexFormat m_indexFormat;
+		int m_vertexCapacity;
+		int m_indexCapacity;
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_indirect = 0;
+
+		std::vector<Allocation> m_meshes; //by id
+		std::vector<int> m_freeIds;
+		FreeList m_freeVertices;
+		FreeList m_freeIndices;
+		int m_numMeshes = 0;
+		size_t m_verticesUsed = 0;
+		size_t m_indicesUsed = 0;
+
+		std::vector<QueuedDraw> m_queue;
+		std::vector<IndirectCommand> m_commands; //kept to reuse its memory
+		InstanceBuffer m_instances;
+		int m_numDefragments = 0;
+		int m_numGrows = 0;
+		int m_lastCommands = 0;
+		int m_lastInstances = 0;
+	};
+}
@@ -0,0 +1,701 @@
+#include "meshOptimize.h"
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+
+namespace ew {
+	VertexCacheStats AnalyzeVertexCache(const MeshData& meshData, int cacheSize)
+	{
+		VertexCacheStats stats;
+		const size_t numIndices = meshData.indices.size();
+		if (numIndices < 3 || cacheSize <= 0)
+			return stats;
+
+		//A vertex is still cached if fewer than cacheSize vertices were transformed since it was
+		std::vector<unsigned int> transformedAt(meshData.vertices.size(), 0);
+		unsigned int time = (unsigned int)cacheSize + 1;
+		int numTransformed = 0;
+		int numReferenced = 0;
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			const unsigned int v = meshData.indices[i];
+			if (transformedAt[v] == 0)
+				numReferenced++;
+			if (time - transformedAt[v] > (unsigned int)cacheSize) {
+				transformedAt[v] = time++;
+				numTransformed++;
+			}
+		}
+		stats.acmr = (float)numTransformed / (float)(numIndices / 3);
+		stats.atvr = (float)numTransformed / (float)numReferenced;
+		return stats;
+	}
+
+	//Forsyth's scoring. The cache size is the one the order is tuned for, larger than any real cache does no harm
+	static const int FORSYTH_CACHE_SIZE = 32;
+	static const int FORSYTH_MAX_VALENCE = 32;
+
+	struct ForsythScores {
+		float cache[FORSYTH_CACHE_SIZE];
+		float valence[FORSYTH_MAX_VALENCE + 1];
+	};
+
+	static const ForsythScores& GetForsythScores()
+	{
+		static const ForsythScores scores = [] {
+			ForsythScores s;
+			for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+			{
+				//The last triangle's vertices get a fixed score, so its neighbours aren't favoured over the ones sharing an edge with older triangles
+				s.cache[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+			}
+			s.valence[0] = 0.0f;
+			for (int i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+			{
+				//Vertices with few triangles left are finished first, so they leave the working set early
+				s.valence[i] = 2.0f / sqrtf((float)i);
+			}
+			return s;
+		}();
+		return scores;
+	}
+
+	static float VertexScore(const ForsythScores& scores, int cachePosition, int numLiveTriangles)
+	{
+		if (numLiveTriangles == 0)
+			return -1.0f;
+		float score = cachePosition >= 0 ? scores.cache[cachePosition] : 0.0f;
+		return score + scores.valence[numLiveTriangles < FORSYTH_MAX_VALENCE ? numLiveTriangles : FORSYTH_MAX_VALENCE];
+	}
+
+	void OptimizeVertexCache(MeshData& meshData)
+	{
+		const int numTriangles = (int)(meshData.indices.size() / 3);
+		const int numVertices = (int)meshData.vertices.size();
+		if (numTriangles == 0)
+			return;
+		const ForsythScores& scores = GetForsythScores();
+		const std::vector<unsigned int>& indices = meshData.indices;
+
+		//Triangles using each vertex, in adjacency[offsets[v], offsets[v] + numLive[v]). Emitted triangles are swapped past the end
+		std::vector<int> numLive(numVertices, 0);
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			numLive[indices[i]]++;
+		}
+		std::vector<int> offsets(numVertices + 1, 0);
+		for (int v = 0; v < numVertices; v++)
+		{
+			offsets[v + 1] = offsets[v] + numLive[v];
+		}
+		std::vector<int> adjacency(numTriangles * 3);
+		{
+			std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+			for (int i = 0; i < numTriangles * 3; i++)
+			{
+				adjacency[fill[indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<int> cachePosition(numVertices, -1);
+		std::vector<float> vertexScore(numVertices);
+		for (int v = 0; v < numVertices; v++)
+		{
+			vertexScore[v] = VertexScore(scores, -1, numLive[v]);
+		}
+		std::vector<float> triangleScore(numTriangles);
+		int best = 0;
+		for (int t = 0; t < numTriangles; t++)
+		{
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+			best = triangleScore[t] > triangleScore[best] ? t : best;
+		}
+		std::vector<unsigned char> emitted(numTriangles, 0);
+
+		int cache[FORSYTH_CACHE_SIZE + 3];
+		int newCache[FORSYTH_CACHE_SIZE + 3];
+		int cacheCount = 0;
+		int nextUnemitted = 0; //triangles before it are all emitted
+		std::vector<unsigned int> sorted(numTriangles * 3);
+		for (int numEmitted = 0; numEmitted < numTriangles; numEmitted++)
+		{
+			//Nothing in the cache is connected to a live triangle, continue with the first one left in input order
+			if (best < 0) {
+				while (emitted[nextUnemitted])
+					nextUnemitted++;
+				best = nextUnemitted;
+			}
+			const unsigned int* triangle = &indices[best * 3];
+			sorted[numEmitted * 3] = triangle[0];
+			sorted[numEmitted * 3 + 1] = triangle[1];
+			sorted[numEmitted * 3 + 2] = triangle[2];
+			emitted[best] = 1;
+
+			for (int i = 0; i < 3; i++)
+			{
+				const int v = triangle[i];
+				int* list = &adjacency[offsets[v]];
+				for (int j = 0; j < numLive[v]; j++)
+				{
+					if (list[j] == best) {
+						list[j] = list[numLive[v] - 1];
+						numLive[v]--;
+						break;
+					}
+				}
+			}
+
+			//The triangle's vertices move to the front, the rest shift back and the overflow falls out
+			int newCount = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				const int v = triangle[i];
+				bool duplicate = false;
+				for (int j = 0; j < newCount; j++)
+				{
+					duplicate = duplicate || newCache[j] == v;
+				}
+				if (!duplicate)
+					newCache[newCount++] = v;
+			}
+			for (int i = 0; i < cacheCount; i++)
+			{
+				const int v = cache[i];
+				if (v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2])
+					newCache[newCount++] = v;
+			}
+
+			//Rescore every vertex whose cache position changed, including the ones that fell out
+			for (int i = 0; i < newCount; i++)
+			{
+				const int v = newCache[i];
+				cachePosition[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+				const float score = VertexScore(scores, cachePosition[v], numLive[v]);
+				const float delta = score - vertexScore[v];
+				vertexScore[v] = score;
+				const int* list = &adjacency[offsets[v]];
+				for (int j = 0; j < numLive[v]; j++)
+				{
+					triangleScore[list[j]] += delta;
+				}
+			}
+			cacheCount = newCount < FORSYTH_CACHE_SIZE ? newCount : FORSYTH_CACHE_SIZE;
+			for (int i = 0; i < cacheCount; i++)
+			{
+				cache[i] = newCache[i];
+			}
+
+			//Only triangles touching the cache can have changed, so the next one is searched there
+			best = -1;
+			float bestScore = -1.0f;
+			for (int i = 0; i < cacheCount; i++)
+			{
+				const int v = cache[i];
+				const int* list = &adjacency[offsets[v]];
+				for (int j = 0; j < numLive[v]; j++)
+				{
+					if (triangleScore[list[j]] > bestScore) {
+						bestScore = triangleScore[list[j]];
+						best = list[j];
+					}
+				}
+			}
+		}
+		meshData.indices.swap(sorted);
+	}
+
+	void OptimizeVertexFetch(MeshData& meshData)
+	{
+		const int numVertices = (int)meshData.vertices.size();
+		std::vector<int> remap(numVertices, -1);
+		int next = 0;
+		for (unsigned int& index : meshData.indices)
+		{
+			if (remap[index] < 0)
+				remap[index] = next++;
+			index = (unsigned int)remap[index];
+		}
+		for (int v = 0; v < numVertices; v++)
+		{
+			if (remap[v] < 0)
+				remap[v] = next++;
+		}
+		std::vector<Vertex> vertices(numVertices);
+		for (int v = 0; v < numVertices; v++)
+		{
+			vertices[remap[v]] = meshData.vertices[v];
+		}
+		meshData.vertices.swap(vertices);
+	}
+
+	MeshOptimizeReport OptimizeMesh(MeshData& meshData, int cacheSize)
+	{
+		MeshOptimizeReport report;
+		report.before = AnalyzeVertexCache(meshData, cacheSize);
+		OptimizeVertexCache(meshData);
+		OptimizeVertexFetch(meshData);
+		report.after = AnalyzeVertexCache(meshData, cacheSize);
+		return report;
+	}
+
+	//Calls job(i) for i in [0, count), on pool if there is one
+	static void ParallelFor(ThreadPool* pool, size_t count, const std::function<void(size_t)>& job)
+	{
+		if (pool) {
+			pool->parallelFor(count, job);
+			return;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			job(i);
+		}
+	}
+
+	static uint64_t HashWords(const uint32_t* words, int numWords)
+	{
+		uint64_t hash = 0x9E3779B97F4A7C15ull ^ (uint64_t)numWords;
+		for (int i = 0; i < numWords; i += 2)
+		{
+			const uint64_t pair = words[i] | (i + 1 < numWords ? (uint64_t)words[i + 1] << 32 : 0);
+			hash = (hash ^ pair) * 0xff51afd7ed558ccdull;
+			hash ^= hash >> 32;
+		}
+		//Finalizer, the partition is taken from the top bits and the table slot from the bottom ones
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	//Bits of the attributes compared by EXACT welding, with -0 turned into 0. Returns the number of words
+	static int ExactWords(const Vertex& v, const WeldSettings& settings, uint32_t* words)
+	{
+		float values[8] = { v.pos.x, v.pos.y, v.pos.z };
+		int numValues = 3;
+		if (settings.compareNormals) {
+			values[numValues++] = v.normal.x;
+			values[numValues++] = v.normal.y;
+			values[numValues++] = v.normal.z;
+		}
+		if (settings.compareUVs) {
+			values[numValues++] = v.uv.x;
+			values[numValues++] = v.uv.y;
+		}
+		for (int i = 0; i < numValues; i++)
+		{
+			const float value = values[i] == 0.0f ? 0.0f : values[i];
+			memcpy(&words[i], &value, 4);
+		}
+		return numValues;
+	}
+
+	static bool Near(const ew::Vec3& a, const ew::Vec3& b, float epsilon)
+	{
+		return fabsf(a.x - b.x) <= epsilon && fabsf(a.y - b.y) <= epsilon && fabsf(a.z - b.z) <= epsilon;
+	}
+
+	static bool NearVertex(const Vertex& a, const Vertex& b, const WeldSettings& settings)
+	{
+		return Near(a.pos, b.pos, settings.positionEpsilon)
+			&& (!settings.compareNormals || Near(a.normal, b.normal, settings.normalEpsilon))
+			&& (!settings.compareUVs || (fabsf(a.uv.x - b.uv.x) <= settings.uvEpsilon && fabsf(a.uv.y - b.uv.y) <= settings.uvEpsilon));
+	}
+
+	static const int WELD_PARTITION_BITS = 8;
+	static const int WELD_PARTITIONS = 1 << WELD_PARTITION_BITS;
+	static const size_t WELD_BLOCK_SIZE = 1 << 16;
+
+	//Open addressing table of one partition, mapping a hash to a position in the partition's vertex list
+	struct WeldTable {
+		std::vector<int> slots; //position + 1, 0 is empty
+		size_t mask = 0;
+
+		void init(size_t count) {
+			size_t size = 16;
+			while (size < count * 2)
+				size *= 2;
+			slots.assign(size, 0);
+			mask = size - 1;
+		}
+	};
+
+	WeldReport WeldVertices(MeshData& meshData, const WeldSettings& settings, ThreadPool* pool)
+	{
+		WeldReport report;
+		const size_t numVertices = meshData.vertices.size();
+		report.verticesBefore = (int)numVertices;
+		report.verticesAfter = (int)numVertices;
+		if (numVertices == 0)
+			return report;
+		const Vertex* vertices = meshData.vertices.data();
+		const bool exact = settings.mode == WeldMode::EXACT;
+		const size_t numBlocks = (numVertices + WELD_BLOCK_SIZE - 1) / WELD_BLOCK_SIZE;
+
+		//Hash every vertex. EPSILON hashes the grid cell of the position only, the other attributes are compared later
+		const float cellSize = settings.positionEpsilon * 4.0f;
+		const float invCellSize = cellSize > 0.0f ? 1.0f / cellSize : 0.0f;
+		auto cellOf = [invCellSize](float value) {
+			const float cell = floorf(value * invCellSize);
+			return (int32_t)(cell < -2.0e9f ? -2.0e9f : (cell > 2.0e9f ? 2.0e9f : cell));
+		};
+		std::vector<uint64_t> hashes(numVertices);
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				uint32_t words[8];
+				if (exact) {
+					hashes[v] = HashWords(words, ExactWords(vertices[v], settings, words));
+				}
+				else {
+					const int32_t cell[3] = { cellOf(vertices[v].pos.x), cellOf(vertices[v].pos.y), cellOf(vertices[v].pos.z) };
+					hashes[v] = HashWords((const uint32_t*)cell, 3);
+				}
+			}
+		});
+
+		//Stable counting sort into partitions, so every partition lists its vertices in vertex order
+		std::vector<size_t> blockCounts(numBlocks * WELD_PARTITIONS, 0);
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			size_t* counts = &blockCounts[block * WELD_PARTITIONS];
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				counts[hashes[v] >> (64 - WELD_PARTITION_BITS)]++;
+			}
+		});
+		std::vector<size_t> partitionStart(WELD_PARTITIONS + 1, 0);
+		size_t offset = 0;
+		for (int partition = 0; partition < WELD_PARTITIONS; partition++)
+		{
+			partitionStart[partition] = offset;
+			for (size_t block = 0; block < numBlocks; block++)
+			{
+				const size_t count = blockCounts[block * WELD_PARTITIONS + partition];
+				blockCounts[block * WELD_PARTITIONS + partition] = offset;
+				offset += count;
+			}
+		}
+		partitionStart[WELD_PARTITIONS] = offset;
+		//Hashes and vertices are copied in partition order too, so welding a partition reads contiguous memory instead of the whole mesh
+		std::vector<int> order(numVertices);
+		std::vector<uint64_t> sortedHashes(numVertices);
+		std::vector<Vertex> sortedVertices(numVertices);
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			size_t* next = &blockCounts[block * WELD_PARTITIONS];
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				const size_t i = next[hashes[v] >> (64 - WELD_PARTITION_BITS)]++;
+				order[i] = (int)v;
+				sortedHashes[i] = hashes[v];
+				sortedVertices[i] = vertices[v];
+			}
+		});
+
+		//Index of the vertex each one is merged into, itself if it is kept
+		std::vector<int> keep(numVertices);
+		std::vector<WeldTable> tables(WELD_PARTITIONS);
+		if (exact) {
+			//Partitions share no hashes, so each one is welded on its own
+			ParallelFor(pool, WELD_PARTITIONS, [&](size_t partition) {
+				const size_t begin = partitionStart[partition], end = partitionStart[partition + 1];
+				WeldTable& table = tables[partition];
+				table.init(end - begin);
+				for (size_t i = begin; i < end; i++)
+				{
+					const int v = order[i];
+					size_t slot = sortedHashes[i] & table.mask;
+					keep[v] = v;
+					while (table.slots[slot]) {
+						const size_t other = begin + table.slots[slot] - 1;
+						if (sortedHashes[other] == sortedHashes[i]) {
+							uint32_t words[8], otherWords[8];
+							const int numWords = ExactWords(sortedVertices[i], settings, words);
+							ExactWords(sortedVertices[other], settings, otherWords);
+							if (memcmp(words, otherWords, numWords * 4) == 0) {
+								keep[v] = order[other];
+								break;
+							}
+						}
+						slot = (slot + 1) & table.mask;
+					}
+					if (keep[v] == v)
+						table.slots[slot] = (int)(i - begin) + 1;
+				}
+			});
+		}
+		else {
+			//Group each partition by cell hash, vertex order within a cell, and index the first vertex of every cell
+			ParallelFor(pool, WELD_PARTITIONS, [&](size_t partition) {
+				const size_t begin = partitionStart[partition], end = partitionStart[partition + 1];
+				std::vector<size_t> byCell(end - begin);
+				for (size_t i = 0; i < byCell.size(); i++)
+				{
+					byCell[i] = begin + i;
+				}
+				std::stable_sort(byCell.begin(), byCell.end(), [&sortedHashes](size_t a, size_t b) { return sortedHashes[a] < sortedHashes[b]; });
+				std::vector<int> cellOrder(byCell.size());
+				std::vector<Vertex> cellVertices(byCell.size());
+				for (size_t i = 0; i < byCell.size(); i++)
+				{
+					cellOrder[i] = order[byCell[i]];
+					cellVertices[i] = sortedVertices[byCell[i]];
+				}
+				for (size_t i = 0; i < byCell.size(); i++)
+				{
+					sortedHashes[begin + i] = hashes[cellOrder[i]];
+					order[begin + i] = cellOrder[i];
+					sortedVertices[begin + i] = cellVertices[i];
+				}
+
+				WeldTable& table = tables[partition];
+				table.init(end - begin);
+				for (size_t i = begin; i < end; i++)
+				{
+					if (i != begin && sortedHashes[i] == sortedHashes[i - 1])
+						continue;
+					size_t slot = sortedHashes[i] & table.mask;
+					while (table.slots[slot])
+						slot = (slot + 1) & table.mask;
+					table.slots[slot] = (int)(i - begin) + 1;
+				}
+			});
+
+			//Smallest vertex index below limit within epsilon of vertex that accept(index) allows, limit if there is none.
+			//Cells are 4 epsilons wide, so the neighbour along an axis is only searched when vertex is within a quarter cell of that side
+			auto findNear = [&](const Vertex& vertex, int limit, const std::function<bool(int)>& accept) {
+				const ew::Vec3& p = vertex.pos;
+				const int32_t cell[3] = { cellOf(p.x), cellOf(p.y), cellOf(p.z) };
+				int32_t neighbour[3];
+				int numSearched[3];
+				const float positions[3] = { p.x, p.y, p.z };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					const float fraction = positions[axis] * invCellSize - (float)cell[axis];
+					neighbour[axis] = fraction < 0.5f ? cell[axis] - 1 : cell[axis] + 1;
+					numSearched[axis] = (fraction <= 0.25f || fraction >= 0.75f) ? 2 : 1;
+				}
+				int found = limit;
+				for (int z = 0; z < numSearched[2]; z++)
+					for (int y = 0; y < numSearched[1]; y++)
+						for (int x = 0; x < numSearched[0]; x++)
+						{
+							const int32_t search[3] = { x ? neighbour[0] : cell[0], y ? neighbour[1] : cell[1], z ? neighbour[2] : cell[2] };
+							const uint64_t hash = HashWords((const uint32_t*)search, 3);
+							const size_t partition = hash >> (64 - WELD_PARTITION_BITS);
+							const size_t begin = partitionStart[partition], end = partitionStart[partition + 1];
+							const WeldTable& table = tables[partition];
+							size_t slot = hash & table.mask;
+							while (table.slots[slot] && sortedHashes[begin + table.slots[slot] - 1] != hash)
+								slot = (slot + 1) & table.mask;
+							if (!table.slots[slot])
+								continue;
+							//Runs are in vertex order, so the first match in each is the smallest
+							for (size_t i = begin + table.slots[slot] - 1; i < end && sortedHashes[i] == hash && order[i] < found; i++)
+							{
+								if (NearVertex(vertex, sortedVertices[i], settings) && accept(order[i])) {
+									found = order[i];
+									break;
+								}
+							}
+						}
+				return found;
+			};
+
+			//Every vertex is merged into the first vertex near it, unless that one is merged into an even earlier vertex itself.
+			//Then it goes to the first kept vertex near it, or is kept. Both passes only read what the previous one wrote, so partitions run in parallel
+			std::vector<int> first(numVertices);
+			ParallelFor(pool, WELD_PARTITIONS, [&](size_t partition) {
+				for (size_t i = partitionStart[partition]; i < partitionStart[partition + 1]; i++)
+				{
+					first[order[i]] = findNear(sortedVertices[i], order[i], [](int) { return true; });
+				}
+			});
+			ParallelFor(pool, WELD_PARTITIONS, [&](size_t partition) {
+				for (size_t i = partitionStart[partition]; i < partitionStart[partition + 1]; i++)
+				{
+					const int v = order[i];
+					if (first[v] == v || first[first[v]] == first[v])
+						keep[v] = first[v];
+					else
+						keep[v] = findNear(sortedVertices[i], v, [&first](int other) { return first[other] == other; });
+				}
+			});
+		}
+
+		//Kept vertices are numbered in vertex order, then every merged one takes the number of the vertex it joined
+		std::vector<int> remap(numVertices);
+		std::vector<int> blockKept(numBlocks + 1, 0);
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			int count = 0;
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				count += keep[v] == (int)v ? 1 : 0;
+			}
+			blockKept[block + 1] = count;
+		});
+		for (size_t block = 0; block < numBlocks; block++)
+		{
+			blockKept[block + 1] += blockKept[block];
+		}
+		const int numKept = blockKept[numBlocks];
+		if (numKept == (int)numVertices)
+			return report;
+
+		std::vector<Vertex> welded(numKept);
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			int next = blockKept[block];
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				if (keep[v] == (int)v) {
+					welded[next] = vertices[v];
+					remap[v] = next++;
+				}
+			}
+		});
+		//Merged vertices always point at an earlier kept one, numbered by now
+		ParallelFor(pool, numBlocks, [&](size_t block) {
+			const size_t end = std::min(numVertices, (block + 1) * WELD_BLOCK_SIZE);
+			for (size_t v = block * WELD_BLOCK_SIZE; v < end; v++)
+			{
+				if (keep[v] != (int)v)
+					remap[v] = remap[keep[v]];
+			}
+		});
+		const size_t numIndices = meshData.indices.size();
+		ParallelFor(pool, (numIndices + WELD_BLOCK_SIZE - 1) / WELD_BLOCK_SIZE, [&](size_t block) {
+			const size_t end = std::min(numIndices, (block + 1) * WELD_BLOCK_SIZE);
+			for (size_t i = block * WELD_BLOCK_SIZE; i < end; i++)
+			{
+				meshData.indices[i] = (unsigned int)remap[meshData.indices[i]];
+			}
+		});
+		meshData.vertices.swap(welded);
+
+		report.verticesAfter = numKept;
+		report.bytesSaved = (numVertices - numKept) * sizeof(Vertex);
+		return report;
+	}
+
+	std::vector<unsigned int> StripifyMesh(const MeshData& meshData)
+	{
+		std::vector<unsigned int> strips;
+		const int numTriangles = (int)(meshData.indices.size() / 3);
+		const int numVertices = (int)meshData.vertices.size();
+		const unsigned int* indices = meshData.indices.data();
+
+		//Triangles using each vertex, in adjacency[offsets[v], offsets[v + 1])
+		std::vector<int> offsets(numVertices + 1, 0);
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			offsets[indices[i] + 1]++;
+		}
+		for (int v = 0; v < numVertices; v++)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+		std::vector<int> adjacency(numTriangles * 3);
+		{
+			std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+			for (int i = 0; i < numTriangles * 3; i++)
+			{
+				adjacency[fill[indices[i]]++] = i / 3;
+			}
+		}
+
+		//Degenerate triangles draw nothing, they start out used
+		std::vector<unsigned char> used(numTriangles, 0);
+		for (int t = 0; t < numTriangles; t++)
+		{
+			const unsigned int* triangle = &indices[t * 3];
+			used[t] = triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0];
+		}
+		//Triangles already in the strip being grown, marked with its walk
+		std::vector<int> walked(numTriangles, 0);
+		int walk = 0;
+
+		//Unused triangle not walked yet that holds the directed edge from -> to, with its third vertex. -1 if there is none
+		auto findNext = [&](unsigned int from, unsigned int to, unsigned int& third) {
+			for (int i = offsets[from]; i < offsets[from + 1]; i++)
+			{
+				const int t = adjacency[i];
+				if (used[t] || walked[t] == walk)
+					continue;
+				const unsigned int* triangle = &indices[t * 3];
+				for (int c = 0; c < 3; c++)
+				{
+					if (triangle[c] == from && triangle[(c + 1) % 3] == to) {
+						third = triangle[(c + 2) % 3];
+						return t;
+					}
+				}
+			}
+			return -1;
+		};
+		//Grows a strip from triangle first, starting at its vertex rotation, and appends it to out if there is one. Returns the number of triangles.
+		//Odd starts the strip with a repeated vertex, so the first triangle is odd and the next shares its last edge instead of its second
+		auto growStrip = [&](int first, int rotation, bool odd, std::vector<unsigned int>* out) {
+			walk++;
+			const unsigned int* triangle = &indices[first * 3];
+			const unsigned int v0 = triangle[rotation], v1 = triangle[(rotation + 1) % 3], v2 = triangle[(rotation + 2) % 3];
+			walked[first] = walk;
+			if (out) {
+				if (odd) {
+					out->insert(out->end(), { v1, v1, v0, v2 });
+				}
+				else {
+					out->insert(out->end(), { v0, v1, v2 });
+				}
+				used[first] = 1;
+			}
+			//Last two vertices of the strip
+			unsigned int a = odd ? v0 : v1;
+			unsigned int b = v2;
+			int length = 1;
+			while (true) {
+				//The last triangle holds the edge a -> b when it is even in the strip and b -> a when odd, the next one holds it reversed
+				unsigned int third;
+				const int next = ((length + odd) & 1) ? findNext(b, a, third) : findNext(a, b, third);
+				if (next < 0)
+					break;
+				walked[next] = walk;
+				if (out) {
+					out->push_back(third);
+					used[next] = 1;
+				}
+				a = b;
+				b = third;
+				length++;
+			}
+			return length;
+		};
+
+		for (int t = 0; t < numTriangles; t++)
+		{
+			if (used[t])
+				continue;
+			//Odd starts cost an index, they only win when they grow a longer strip
+			int bestRotation = 0;
+			bool bestOdd = false;
+			int bestLength = 0;
+			for (int start = 0; start < 6; start++)
+			{
+				const int length = growStrip(t, start % 3, start >= 3, nullptr);
+				if (length > bestLength) {
+					bestLength = length;
+					bestRotation = start % 3;
+					bestOdd = start >= 3;
+				}
+			}
+			if (!strips.empty())
+				strips.push_back(PRIMITIVE_RESTART_INDEX);
+			growStrip(t, bestRotation, bestOdd, &strips);
+		}
+		return strips;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "mesh.h"
+#include "threadPool.h"
+
+namespace ew {
+	/// <summary>
+	/// Post-transform vertex cache behaviour of an index buffer, from a simulated FIFO cache.
+	/// ACMR: vertex shader invocations per triangle. 3 with no reuse, about 0.5 to 0.7 is the best a regular grid can do.
+	/// ATVR: vertex shader invocations per referenced vertex. 1 is perfect.
+	/// </summary>
+	struct VertexCacheStats {
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+	//cacheSize matches the hardware being estimated, 16 to 32 entries on current GPUs
+	VertexCacheStats AnalyzeVertexCache(const MeshData& meshData, int cacheSize = 16);
+
+	//Reorders triangles so vertices are reused while still in the post-transform cache (Forsyth's linear-speed algorithm). Vertices are untouched
+	void OptimizeVertexCache(MeshData& meshData);
+	//Reorders vertices by first use in the index buffer and remaps the indices, so vertex fetches walk memory forwards.
+	//Vertices no triangle uses are kept at the end
+	void OptimizeVertexFetch(MeshData& meshData);
+
+	struct MeshOptimizeReport {
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+	//OptimizeVertexCache then OptimizeVertexFetch, measured before and after with AnalyzeVertexCache
+	MeshOptimizeReport OptimizeMesh(MeshData& meshData, int cacheSize = 16);
+
+	/// <summary>
+	/// Triangle strips covering the triangles of meshData, separated by PRIMITIVE_RESTART_INDEX. Draw them with DrawMode::TRIANGLE_STRIP.
+	/// Each strip starts at the first triangle not in one yet, in the rotation that grows the longest strip across shared edges.
+	/// Every triangle keeps its winding. Degenerate triangles are dropped.
+	/// A regular grid becomes one strip per row, about 2 indices per quad instead of 6, but rows no longer share vertices in the post-transform cache.
+	/// The other functions here expect triangle lists, run them before this.
+	/// </summary>
+	std::vector<unsigned int> StripifyMesh(const MeshData& meshData);
+
+	enum class WeldMode {
+		EXACT = 0, //bit identical attributes, except that -0 equals 0
+		EPSILON = 1 //every compared component within its epsilon of the vertex it is merged into
+	};
+
+	struct WeldSettings {
+		WeldMode mode = WeldMode::EXACT;
+		//Vertices that only match in position are merged when an attribute isn't compared, keeping the first one's value
+		bool compareNormals = true;
+		bool compareUVs = true;
+		float positionEpsilon = 1e-5f;
+		float normalEpsilon = 1e-3f;
+		float uvEpsilon = 1e-5f;
+	};
+
+	struct WeldReport {
+		int verticesBefore = 0;
+		int verticesAfter = 0;
+		size_t bytesSaved = 0; //sizeof(Vertex) per removed vertex
+	};
+
+	/// <summary>
+	/// Merges duplicate vertices and remaps the indices to the ones kept, which stay in vertex order.
+	/// Vertices are hashed in parallel and split into partitions by hash, which are welded independently.
+	/// EXACT keeps the first of every set of identical vertices.
+	/// EPSILON hashes positions on a grid 4 epsilons wide and searches the cells within an epsilon of each vertex, one in most cases.
+	/// A vertex is merged into the first vertex near it if that one is kept, otherwise into the first kept vertex near it,
+	/// so chains of near vertices don't drift further than epsilon from the vertex they end up as.
+	/// </summary>
+	WeldReport WeldVertices(MeshData& meshData, const WeldSettings& settings = WeldSettings(), ThreadPool* pool = nullptr);
+}
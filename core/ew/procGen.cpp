@@ -41,6 +41,19 @@ namespace ew {
 		mesh->indices.push_back(startVertex + 2);
 		mesh->indices.push_back(startVertex);
 	}
+	//Face normals for createCube, folded at compile time
+	static constexpr ew::Vec3 CUBE_FACE_NORMALS[6] = {
+		ew::Vec3{ +0.0f,+0.0f,+1.0f }, //Front
+		ew::Vec3{ +1.0f,+0.0f,+0.0f }, //Right
+		ew::Vec3{ +0.0f,+1.0f,+0.0f }, //Top
+		ew::Vec3{ -1.0f,+0.0f,+0.0f }, //Left
+		ew::Vec3{ +0.0f,-1.0f,+0.0f }, //Bottom
+		ew::Vec3{ +0.0f,+0.0f,-1.0f }  //Back
+	};
+	static_assert(ew::Dot(CUBE_FACE_NORMALS[0], CUBE_FACE_NORMALS[0]) == 1.0f && ew::Dot(CUBE_FACE_NORMALS[1], CUBE_FACE_NORMALS[1]) == 1.0f && ew::Dot(CUBE_FACE_NORMALS[2], CUBE_FACE_NORMALS[2]) == 1.0f
+		&& ew::Dot(CUBE_FACE_NORMALS[3], CUBE_FACE_NORMALS[3]) == 1.0f && ew::Dot(CUBE_FACE_NORMALS[4], CUBE_FACE_NORMALS[4]) == 1.0f && ew::Dot(CUBE_FACE_NORMALS[5], CUBE_FACE_NORMALS[5]) == 1.0f, "Cube face normals are unit length");
+	static_assert(ew::Dot(CUBE_FACE_NORMALS[0], CUBE_FACE_NORMALS[5]) == -1.0f && ew::Dot(CUBE_FACE_NORMALS[1], CUBE_FACE_NORMALS[3]) == -1.0f && ew::Dot(CUBE_FACE_NORMALS[2], CUBE_FACE_NORMALS[4]) == -1.0f, "Cube faces come in opposite pairs");
+	static_assert(ew::Cross(CUBE_FACE_NORMALS[1], CUBE_FACE_NORMALS[2]).z == CUBE_FACE_NORMALS[0].z, "Right x Top = Front");
 	/// <summary>
 	/// Creates a cube of uniform size
 	/// </summary>
@@ -50,12 +63,9 @@ namespace ew {
 		MeshData mesh;
 		mesh.vertices.reserve(24); //6 x 4 vertices
 		mesh.indices.reserve(36); //6 x 6 indices
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,+1.0f }, size, &mesh); //Front
-		createCubeFace(ew::Vec3{ +1.0f,+0.0f,+0.0f }, size, &mesh); //Right
-		createCubeFace(ew::Vec3{ +0.0f,+1.0f,+0.0f }, size, &mesh); //Top
-		createCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
-		createCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		for (const ew::Vec3& normal : CUBE_FACE_NORMALS) {
+			createCubeFace(normal, size, &mesh);
+		}
 		return mesh;
 	}
 	MeshData createPlane(float width, float height, int subdivisions)
@@ -120,6 +120,10 @@ namespace ew {
 	{
 		setVec4(name, v.x, v.y, v.z, v.w);
 	}
+	void Shader::setMat3(const std::string& name, const ew::Mat3& m) const
+	{
+		glUniformMatrix3fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &m[0][0]);
+	}
 	void Shader::setMat4(const std::string& name, const ew::Mat4& m) const
 	{
 		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &m[0][0]);
@@ -0,0 +1,102 @@
+#include "threadPool.h"
+
+namespace ew {
+	//Set while a thread runs jobs of a batch, on workers and the submitting thread alike, so nested parallelFor calls run inline
+	static thread_local bool t_inJob = false;
+
+	ThreadPool::ThreadPool(unsigned int numThreads)
+	{
+		if (numThreads == 0) {
+			numThreads = std::thread::hardware_concurrency();
+			numThreads = numThreads == 0 ? 1 : numThreads;
+		}
+		for (unsigned int i = 1; i < numThreads; i++)
+		{
+			m_workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+	/// <summary>
+	/// Claims indices of the current batch until none are left.
+	/// </summary>
+	void ThreadPool::runJobs(const std::function<void(size_t)>& job, size_t count)
+	{
+		t_inJob = true;
+		size_t finished = 0;
+		for (size_t i = m_next.fetch_add(1); i < count; i = m_next.fetch_add(1))
+		{
+			job(i);
+			finished++;
+		}
+		t_inJob = false;
+		m_remaining.fetch_sub(finished);
+	}
+	void ThreadPool::workerLoop()
+	{
+		unsigned int seenGeneration = 0;
+		while (true)
+		{
+			const std::function<void(size_t)>* job;
+			size_t count;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+				if (m_stop)
+					return;
+				seenGeneration = m_generation;
+				//The batch may already be over if this worker woke up late
+				if (!m_job)
+					continue;
+				job = m_job;
+				count = m_count;
+				m_numActive++;
+			}
+			runJobs(*job, count);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_numActive--;
+			}
+			m_done.notify_all();
+		}
+	}
+	void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& job)
+	{
+		if (count == 0)
+			return;
+		if (m_workers.empty() || count == 1 || t_inJob) {
+			for (size_t i = 0; i < count; i++)
+			{
+				job(i);
+			}
+			return;
+		}
+
+		std::lock_guard<std::mutex> submitLock(m_submitMutex);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job = &job;
+			m_count = count;
+			m_next.store(0);
+			m_remaining.store(count);
+			m_generation++;
+		}
+		m_wake.notify_all();
+		runJobs(job, count);
+
+		//Workers may still be finishing their last index. Closing the batch under the lock keeps late workers from joining it.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [&] { return m_remaining.load() == 0 && m_numActive == 0; });
+		m_job = nullptr;
+	}
+}
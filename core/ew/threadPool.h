@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace ew {
+	/// <summary>
+	/// Fixed set of worker threads, created once and reused.
+	/// parallelFor hands out indices from a shared counter, so uneven jobs balance themselves. The calling thread works too.
+	/// </summary>
+	class ThreadPool {
+	public:
+		/// <param name="numThreads">Threads taking part in parallelFor, including the caller. 0 uses every hardware thread, 1 runs everything on the caller.</param>
+		ThreadPool(unsigned int numThreads = 0);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// <summary>
+		/// Calls job(i) for every i in [0, count) and returns when all calls are done.
+		/// Calls from inside a job, on a worker or on the calling thread, run serially on that thread instead of deadlocking.
+		/// </summary>
+		void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+		inline unsigned int getNumThreads()const { return (unsigned int)m_workers.size() + 1; }
+	private:
+		void workerLoop();
+		void runJobs(const std::function<void(size_t)>& job, size_t count);
+
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::mutex m_submitMutex; //One parallelFor at a time
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		//Current batch, guarded by m_mutex except for the counters
+		const std::function<void(size_t)>* m_job = nullptr;
+		size_t m_count = 0;
+		std::atomic<size_t> m_next{ 0 };
+		std::atomic<size_t> m_remaining{ 0 };
+		unsigned int m_numActive = 0; //Workers inside runJobs for the current batch
+		unsigned int m_generation = 0; //Bumped for every batch so sleeping workers notice new work
+		bool m_stop = false;
+	};
+}
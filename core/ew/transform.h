@@ -7,12 +7,40 @@ namespace ew {
 		ew::Vec3 rotation = ew::Vec3(0.0f, 0.0f, 0.0f); //Euler angles (Degrees)
 		ew::Vec3 scale = ew::Vec3(1.0f, 1.0f, 1.0f);
 
+		//Cached. Only recomposed when position, rotation or scale changed since the last call.
 		ew::Mat4 getModelMatrix() const {
-			return ew::Translate(position)
-				* ew::RotateY(ew::Radians(rotation.y))
-				* ew::RotateX(ew::Radians(rotation.x))
-				* ew::RotateZ(ew::Radians(rotation.z))
-				* ew::Scale(scale);
+			update();
+			return m_model;
 		}
+		//Upload as _NormalMatrix so shaders don't need to invert _Model per vertex
+		ew::Mat3 getNormalMatrix() const {
+			update();
+			return m_normal;
+		}
+	private:
+		static bool equal(const ew::Vec3& a, const ew::Vec3& b) {
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+		void update() const {
+			if (m_valid && equal(position, m_cachedPosition) && equal(rotation, m_cachedRotation) && equal(scale, m_cachedScale)) {
+				return;
+			}
+			m_cachedPosition = position;
+			m_cachedRotation = rotation;
+			m_cachedScale = scale;
+			m_model = ew::TRS(position, ew::Vec3(ew::Radians(rotation.x), ew::Radians(rotation.y), ew::Radians(rotation.z)), scale);
+			//Rotation is orthonormal, so inverse(transpose(R*S)) is R*S^-1: just divide each column by its scale again
+			m_normal = ew::Mat3(
+				m_model[0].toVec3() / (scale.x * scale.x),
+				m_model[1].toVec3() / (scale.y * scale.y),
+				m_model[2].toVec3() / (scale.z * scale.z));
+			m_valid = true;
+		}
+		mutable ew::Vec3 m_cachedPosition{};
+		mutable ew::Vec3 m_cachedRotation{};
+		mutable ew::Vec3 m_cachedScale{};
+		mutable ew::Mat4 m_model{};
+		mutable ew::Mat3 m_normal{};
+		mutable bool m_valid = false;
 	};
 }
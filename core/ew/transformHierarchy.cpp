@@ -0,0 +1,252 @@
+#include "transformHierarchy.h"
+#include "threadPool.h"
+#include <algorithm>
+
+namespace ew {
+	//Below this many dirty nodes per thread the update stays on the calling thread
+	static const size_t MIN_NODES_PER_THREAD = 4096;
+
+	/// <summary>
+	/// Reorders an array by slot so that out[newSlot] = in[order[newSlot]].
+	/// </summary>
+	template<typename T>
+	static void permute(std::vector<T>& values, const std::vector<int>& order) {
+		std::vector<T> permuted(values.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			permuted[i] = values[order[i]];
+		}
+		values.swap(permuted);
+	}
+
+	int TransformHierarchy::add(int parent, const ew::Vec3& position, const ew::Vec3& rotation, const ew::Vec3& scale)
+	{
+		int handle = (int)m_slots.size();
+		int slot = (int)m_handles.size();
+		m_slots.push_back(slot);
+		m_handles.push_back(handle);
+		m_positions.push_back(position);
+		m_rotations.push_back(rotation);
+		m_scales.push_back(scale);
+		m_parents.push_back(parent == NO_PARENT ? NO_PARENT : m_slots[parent]);
+		m_subtreeSizes.push_back(1);
+		m_local.push_back(ew::IdentityMatrix());
+		m_world.push_back(ew::IdentityMatrix());
+		m_localDirty.push_back(1);
+		//New slots are appended, so subtrees are no longer contiguous until the order is rebuilt
+		m_orderDirty = true;
+		return handle;
+	}
+	void TransformHierarchy::reserve(size_t capacity)
+	{
+		m_slots.reserve(capacity);
+		m_handles.reserve(capacity);
+		m_positions.reserve(capacity);
+		m_rotations.reserve(capacity);
+		m_scales.reserve(capacity);
+		m_parents.reserve(capacity);
+		m_subtreeSizes.reserve(capacity);
+		m_local.reserve(capacity);
+		m_world.reserve(capacity);
+		m_localDirty.reserve(capacity);
+	}
+	void TransformHierarchy::clear()
+	{
+		m_slots.clear();
+		m_handles.clear();
+		m_positions.clear();
+		m_rotations.clear();
+		m_scales.clear();
+		m_parents.clear();
+		m_subtreeSizes.clear();
+		m_local.clear();
+		m_world.clear();
+		m_localDirty.clear();
+		m_dirtySlots.clear();
+		m_orderDirty = false;
+		m_numUpdated = 0;
+	}
+	int TransformHierarchy::getParent(int node) const
+	{
+		int parentSlot = m_parents[m_slots[node]];
+		return parentSlot == NO_PARENT ? NO_PARENT : m_handles[parentSlot];
+	}
+	void TransformHierarchy::markDirty(int slot)
+	{
+		if (!m_localDirty[slot]) {
+			m_localDirty[slot] = 1;
+			m_dirtySlots.push_back(slot);
+		}
+	}
+	void TransformHierarchy::setPosition(int node, const ew::Vec3& position)
+	{
+		int slot = m_slots[node];
+		m_positions[slot] = position;
+		markDirty(slot);
+	}
+	void TransformHierarchy::setRotation(int node, const ew::Vec3& rotation)
+	{
+		int slot = m_slots[node];
+		m_rotations[slot] = rotation;
+		markDirty(slot);
+	}
+	void TransformHierarchy::setScale(int node, const ew::Vec3& scale)
+	{
+		int slot = m_slots[node];
+		m_scales[slot] = scale;
+		markDirty(slot);
+	}
+	/// <summary>
+	/// Sorts storage into depth first order and recomputes subtree sizes. Only runs after nodes were added.
+	/// </summary>
+	void TransformHierarchy::rebuildOrder()
+	{
+		const int count = (int)m_handles.size();
+
+		//Children of each slot, packed by parent (counting sort keeps siblings in slot order)
+		std::vector<int> childOffsets(count + 1, 0);
+		for (int slot = 0; slot < count; slot++)
+		{
+			if (m_parents[slot] != NO_PARENT)
+				childOffsets[m_parents[slot] + 1]++;
+		}
+		for (int slot = 0; slot < count; slot++)
+		{
+			childOffsets[slot + 1] += childOffsets[slot];
+		}
+		std::vector<int> children(childOffsets[count]);
+		std::vector<int> next(childOffsets.begin(), childOffsets.end() - 1);
+		for (int slot = 0; slot < count; slot++)
+		{
+			if (m_parents[slot] != NO_PARENT)
+				children[next[m_parents[slot]]++] = slot;
+		}
+
+		//Depth first walk from each root
+		std::vector<int> order;
+		order.reserve(count);
+		std::vector<int> stack;
+		for (int root = 0; root < count; root++)
+		{
+			if (m_parents[root] != NO_PARENT)
+				continue;
+			stack.push_back(root);
+			while (!stack.empty())
+			{
+				int slot = stack.back();
+				stack.pop_back();
+				order.push_back(slot);
+				//Reverse push so children are visited in slot order
+				for (int c = childOffsets[slot + 1] - 1; c >= childOffsets[slot]; c--)
+				{
+					stack.push_back(children[c]);
+				}
+			}
+		}
+
+		std::vector<int> newSlotOf(count);
+		for (int i = 0; i < count; i++)
+		{
+			newSlotOf[order[i]] = i;
+		}
+		std::vector<int> parents(count);
+		for (int i = 0; i < count; i++)
+		{
+			int oldParent = m_parents[order[i]];
+			parents[i] = oldParent == NO_PARENT ? NO_PARENT : newSlotOf[oldParent];
+		}
+		m_parents.swap(parents);
+		permute(m_handles, order);
+		permute(m_positions, order);
+		permute(m_rotations, order);
+		permute(m_scales, order);
+		permute(m_local, order);
+		permute(m_world, order);
+		permute(m_localDirty, order);
+		for (int i = 0; i < count; i++)
+		{
+			m_slots[m_handles[i]] = i;
+		}
+
+		//Children come after their parent, so accumulate sizes back to front
+		m_subtreeSizes.assign(count, 1);
+		for (int i = count - 1; i > 0; i--)
+		{
+			if (m_parents[i] != NO_PARENT)
+				m_subtreeSizes[m_parents[i]] += m_subtreeSizes[i];
+		}
+		m_orderDirty = false;
+	}
+	/// <summary>
+	/// Recomputes world matrices for a contiguous run of slots. The parent of begin must already be up to date.
+	/// </summary>
+	void TransformHierarchy::updateRange(int begin, int end)
+	{
+		for (int slot = begin; slot < end; slot++)
+		{
+			if (m_localDirty[slot]) {
+				const ew::Vec3& r = m_rotations[slot];
+				m_local[slot] = ew::TRS(m_positions[slot], ew::Vec3(ew::Radians(r.x), ew::Radians(r.y), ew::Radians(r.z)), m_scales[slot]);
+				m_localDirty[slot] = 0;
+			}
+			const int parent = m_parents[slot];
+			m_world[slot] = parent == NO_PARENT ? m_local[slot] : m_world[parent] * m_local[slot];
+		}
+	}
+	void TransformHierarchy::update(ThreadPool* pool)
+	{
+		if (m_orderDirty) {
+			rebuildOrder();
+			updateRange(0, (int)m_handles.size());
+			m_dirtySlots.clear();
+			m_numUpdated = m_handles.size();
+			return;
+		}
+
+		//Merge dirty slots into disjoint subtree ranges. A dirty slot inside an earlier range is already covered.
+		std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+		std::vector<std::pair<int, int>> ranges;
+		size_t numUpdated = 0;
+		int coveredEnd = 0;
+		for (int slot : m_dirtySlots)
+		{
+			if (slot < coveredEnd)
+				continue;
+			coveredEnd = slot + m_subtreeSizes[slot];
+			ranges.push_back(std::make_pair(slot, coveredEnd));
+			numUpdated += m_subtreeSizes[slot];
+		}
+		m_dirtySlots.clear();
+		m_numUpdated = numUpdated;
+
+		const unsigned int numThreads = pool ? pool->getNumThreads() : 1;
+		if (numThreads <= 1 || ranges.size() < 2 || numUpdated < MIN_NODES_PER_THREAD * 2) {
+			for (const std::pair<int, int>& range : ranges)
+			{
+				updateRange(range.first, range.second);
+			}
+			return;
+		}
+
+		//Ranges are independent subtrees, so split them into runs of roughly equal node counts
+		std::vector<size_t> runStarts;
+		runStarts.push_back(0);
+		const size_t target = (numUpdated + numThreads - 1) / numThreads;
+		size_t accumulated = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			accumulated += ranges[i].second - ranges[i].first;
+			if (accumulated >= target * runStarts.size() && runStarts.size() < numThreads && i + 1 < ranges.size()) {
+				runStarts.push_back(i + 1);
+			}
+		}
+		runStarts.push_back(ranges.size());
+
+		pool->parallelFor(runStarts.size() - 1, [&](size_t run) {
+			for (size_t i = runStarts[run]; i < runStarts[run + 1]; i++)
+			{
+				updateRange(ranges[i].first, ranges[i].second);
+			}
+		});
+	}
+}
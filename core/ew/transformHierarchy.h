@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ewMath/ewMath.h"
+#include "ewMath/transformations.h"
+
+namespace ew {
+	class ThreadPool;
+
+	/// <summary>
+	/// Parented transforms stored as parallel arrays (SoA).
+	/// Storage is kept in depth first order so every subtree is a contiguous range with parents before children.
+	/// Nodes are referenced by stable handles returned from add(); handles are remapped to storage slots internally.
+	/// update() only walks the subtrees of nodes whose local TRS changed.
+	/// </summary>
+	class TransformHierarchy {
+	public:
+		static constexpr int NO_PARENT = -1;
+
+		/// <summary>
+		/// Adds a node and returns its handle. The parent must already exist.
+		/// </summary>
+		/// <param name="rotation">Euler angles (Degrees), same convention as ew::Transform</param>
+		int add(int parent = NO_PARENT, const ew::Vec3& position = ew::Vec3(0.0f), const ew::Vec3& rotation = ew::Vec3(0.0f), const ew::Vec3& scale = ew::Vec3(1.0f));
+		void reserve(size_t capacity);
+		void clear();
+
+		void setPosition(int node, const ew::Vec3& position);
+		void setRotation(int node, const ew::Vec3& rotation);
+		void setScale(int node, const ew::Vec3& scale);
+		inline const ew::Vec3& getPosition(int node)const { return m_positions[m_slots[node]]; }
+		inline const ew::Vec3& getRotation(int node)const { return m_rotations[m_slots[node]]; }
+		inline const ew::Vec3& getScale(int node)const { return m_scales[m_slots[node]]; }
+		int getParent(int node)const;
+
+		//Valid after update()
+		inline const ew::Mat4& getLocalMatrix(int node)const { return m_local[m_slots[node]]; }
+		inline const ew::Mat4& getWorldMatrix(int node)const { return m_world[m_slots[node]]; }
+
+		/// <summary>
+		/// Recomputes world matrices of changed nodes and their descendants.
+		/// </summary>
+		/// <param name="pool">Independent dirty subtrees are divided between its threads. No pool runs on the calling thread only.</param>
+		void update(ThreadPool* pool = nullptr);
+
+		inline size_t size()const { return m_slots.size(); }
+		//Number of world matrices recomputed by the last update()
+		inline size_t getNumUpdated()const { return m_numUpdated; }
+	private:
+		void rebuildOrder();
+		void markDirty(int slot);
+		void updateRange(int begin, int end);
+
+		std::vector<int> m_slots; //Handle to storage slot
+
+		//Everything below is indexed by slot
+		std::vector<int> m_handles;
+		std::vector<ew::Vec3> m_positions;
+		std::vector<ew::Vec3> m_rotations;
+		std::vector<ew::Vec3> m_scales;
+		std::vector<int> m_parents; //Parent slot, always lower than the child's slot
+		std::vector<int> m_subtreeSizes; //Node plus all descendants. Subtree of slot i is [i, i + size)
+		std::vector<ew::Mat4> m_local;
+		std::vector<ew::Mat4> m_world;
+		std::vector<uint8_t> m_localDirty;
+
+		std::vector<int> m_dirtySlots; //Slots changed since the last update, unsorted and possibly repeated
+		bool m_orderDirty = false; //Nodes were added, depth first order must be rebuilt
+		size_t m_numUpdated = 0;
+	};
+}
@@ -0,0 +1,130 @@
+#include "landBuilder.h"
+
+namespace wm
+{
+	LandBuilder::LandBuilder(float size, int subdivisions, int previewSubdivisions, const LandSettings& settings, ew::ThreadPool* pool, LandCache* cache,
+		const ew::VertexFormat& format)
+		: m_size(size), m_subdivisions(subdivisions), m_previewSubdivisions(previewSubdivisions), m_settings(settings), m_pool(pool), m_cache(cache), m_format(format), m_cancel(false)
+	{
+		m_pack = format.position != ew::PositionFormat::FLOAT32 || format.normal != ew::NormalFormat::FLOAT32 || format.uv != ew::UVFormat::FLOAT32;
+		m_settings.cancel = &m_cancel;
+		m_thread = std::thread(&LandBuilder::workerLoop, this);
+	}
+
+	LandBuilder::~LandBuilder()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cancel = true;
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	void LandBuilder::request(int seed)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requestedSeed = seed;
+			m_requestId++;
+			// Raised under the lock, so it can't land after the worker picked up this request and cancel it
+			m_cancel = true;
+		}
+		m_wake.notify_one();
+	}
+
+	bool LandBuilder::poll(LandResult& result)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_hasResult)
+			return false;
+		std::swap(result, m_result);
+		m_hasResult = false;
+		return true;
+	}
+
+	bool LandBuilder::isBusy()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_building || m_startedId != m_requestId;
+	}
+
+	// Hands a finished mesh to poll(), unless a newer request made it stale. A full mesh is never replaced by a preview of the same request
+	bool LandBuilder::publish(ew::MeshData& meshData, const std::shared_ptr<const CachedLand>& cached, int seed, unsigned int requestId, bool isPreview)
+	{
+		ew::AABB bounds = cached ? cached->getBounds() : ew::CalculateBounds(meshData);
+		// Converted here so the render thread only copies. Mapped cache files can only go to the GPU as they are in the default format
+		ew::PackedMeshData packed;
+		if (m_pack) {
+			packed = cached ? cached->pack(m_format) : ew::PackMeshData(meshData.vertices.data(), (int)meshData.vertices.size(),
+				meshData.indices.data(), (int)meshData.indices.size(), bounds, m_format);
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (requestId != m_requestId)
+			return false;
+		if (m_pack) {
+			m_result.meshData.vertices.clear();
+			m_result.meshData.indices.clear();
+			m_result.cached = nullptr;
+		}
+		else {
+			m_result.meshData.vertices.swap(meshData.vertices);
+			m_result.meshData.indices.swap(meshData.indices);
+			m_result.cached = cached;
+		}
+		m_result.packed = std::move(packed);
+		m_result.isPacked = m_pack;
+		m_result.bounds = bounds;
+		m_result.seed = seed;
+		m_result.isPreview = isPreview;
+		m_hasResult = true;
+		return true;
+	}
+
+	void LandBuilder::workerLoop()
+	{
+		while (true)
+		{
+			int seed;
+			unsigned int requestId;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_building = false;
+				m_wake.wait(lock, [&] { return m_stop || m_startedId != m_requestId; });
+				if (m_stop)
+					return;
+				seed = m_requestedSeed;
+				requestId = m_requestId;
+				m_startedId = requestId;
+				m_building = true;
+				// Cleared under the lock so a request() after this point always cancels this build
+				m_cancel = false;
+			}
+
+			ew::MeshData land;
+			LandCacheKey key = { m_size, m_subdivisions, seed, m_settings };
+			if (m_cache) {
+				std::shared_ptr<const CachedLand> cached = m_cache->find(key);
+				if (cached) {
+					publish(land, cached, seed, requestId, false);
+					continue;
+				}
+			}
+			if (m_previewSubdivisions > 0 && m_previewSubdivisions < m_subdivisions) {
+				ew::MeshData preview = createLand(m_size, m_previewSubdivisions, seed, m_settings, m_pool);
+				if (m_cancel || !publish(preview, nullptr, seed, requestId, true))
+					continue;
+			}
+			if (m_cache) {
+				std::shared_ptr<const CachedLand> cached = m_cache->get(key, m_pool);
+				if (cached && !m_cancel)
+					publish(land, cached, seed, requestId, false);
+				continue;
+			}
+			land = createLand(m_size, m_subdivisions, seed, m_settings, m_pool);
+			if (!m_cancel)
+				publish(land, nullptr, seed, requestId, false);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "../ew/mesh.h"
+#include "procGen.h"
+#include "landCache.h"
+
+namespace wm
+{
+	// Finished land, ready to upload on the render thread
+	struct LandResult
+	{
+		ew::MeshData meshData;
+		ew::AABB bounds; // computed on the builder thread, pass to ew::Mesh::load
+		std::shared_ptr<const CachedLand> cached; // set instead of meshData when the land came from the cache, upload it with cached->upload
+		ew::PackedMeshData packed; // set instead of meshData and cached when the builder has a non float format, upload it with ew::Mesh::load
+		bool isPacked = false;
+		int seed;
+		bool isPreview; // coarse mesh shown while the full one is still being built
+
+		// Render thread. Only copies to the GPU, any conversion already happened on the builder thread
+		inline void upload(ew::Mesh& mesh)const {
+			if (isPacked)
+				mesh.load(packed);
+			else if (cached)
+				cached->upload(mesh);
+			else
+				mesh.load(meshData, bounds);
+		}
+	};
+
+	// Generates createLand meshes on a background thread so the render thread never waits for them.
+	// Every request first produces a coarse preview and then the full mesh. A newer request cancels
+	// whatever is still being built for an older one, so dragging a seed slider only ever finishes the last seed.
+	// With a cache, full meshes are looked up there first (no preview needed) and stored there once built.
+	// With a non float format, meshes are converted to it on the builder thread as well.
+	class LandBuilder
+	{
+	public:
+		LandBuilder(float size, int subdivisions, int previewSubdivisions, const LandSettings& settings = LandSettings(), ew::ThreadPool* pool = nullptr, LandCache* cache = nullptr,
+			const ew::VertexFormat& format = ew::VertexFormat());
+		~LandBuilder();
+		LandBuilder(const LandBuilder&) = delete;
+		LandBuilder& operator=(const LandBuilder&) = delete;
+
+		void request(int seed);
+		// Takes the newest finished mesh, if there is one the caller hasn't taken yet. Never blocks
+		bool poll(LandResult& result);
+		// True while a request is queued or being built
+		bool isBusy();
+	private:
+		void workerLoop();
+		bool publish(ew::MeshData& meshData, const std::shared_ptr<const CachedLand>& cached, int seed, unsigned int requestId, bool isPreview);
+
+		float m_size;
+		int m_subdivisions;
+		int m_previewSubdivisions;
+		LandSettings m_settings;
+		ew::ThreadPool* m_pool;
+		LandCache* m_cache;
+		ew::VertexFormat m_format;
+		bool m_pack; // m_format isn't ew::Vertex as is
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::atomic<bool> m_cancel; // raised by request() to abandon the build in progress
+
+		// Guarded by m_mutex
+		int m_requestedSeed = 0;
+		unsigned int m_requestId = 0; // increases with every request
+		unsigned int m_startedId = 0; // last request the worker picked up
+		bool m_building = false;
+		bool m_stop = false;
+		LandResult m_result;
+		bool m_hasResult = false;
+	};
+}
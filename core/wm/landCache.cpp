@@ -0,0 +1,232 @@
+#include "landCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace wm
+{
+	// Bumped whenever the file layout or createLand's output changes, so stale files are regenerated instead of loaded
+	static const uint32_t LAND_CACHE_VERSION = 1;
+
+	// Start of every cache file, followed by the vertices and then the indices.
+	// 96 bytes without implicit padding, so the vertices that follow stay 16 byte aligned in the mapping
+	struct LandCacheHeader
+	{
+		char magic[4]; // "LAND"
+		uint32_t version;
+		uint64_t numVertices;
+		uint64_t numIndices;
+		uint32_t vertexSize; // sizeof(ew::Vertex) of the writer
+		float size;
+		int32_t subdivisions;
+		int32_t seed;
+		int32_t noise;
+		int32_t noiseMode;
+		int32_t normals;
+		int32_t rowOffset;
+		int32_t colOffset;
+		float boundsMin[3];
+		float boundsMax[3];
+		uint32_t reserved[3];
+	};
+	static_assert(sizeof(LandCacheHeader) == 96, "LandCacheHeader must not contain padding");
+
+	static bool sameKey(const LandCacheKey& a, const LandCacheKey& b)
+	{
+		return a.size == b.size && a.subdivisions == b.subdivisions && a.seed == b.seed
+			&& a.settings.noise == b.settings.noise && a.settings.noiseMode == b.settings.noiseMode && a.settings.normals == b.settings.normals
+			&& a.settings.rowOffset == b.settings.rowOffset && a.settings.colOffset == b.settings.colOffset;
+	}
+
+	// Header fields describing key, compared field by field when a file is loaded
+	static void writeKey(const LandCacheKey& key, LandCacheHeader& header)
+	{
+		header.size = key.size;
+		header.subdivisions = key.subdivisions;
+		header.seed = key.seed;
+		header.noise = (int32_t)key.settings.noise;
+		header.noiseMode = (int32_t)key.settings.noiseMode;
+		header.normals = (int32_t)key.settings.normals;
+		header.rowOffset = key.settings.rowOffset;
+		header.colOffset = key.settings.colOffset;
+	}
+
+	LandCache::LandCache(const std::string& directory, int maxInMemory)
+		: m_directory(directory), m_maxInMemory(maxInMemory)
+	{
+		if (!m_directory.empty()) {
+			// Fails harmlessly if it already exists
+#ifdef _WIN32
+			_mkdir(m_directory.c_str());
+#else
+			mkdir(m_directory.c_str(), 0755);
+#endif
+		}
+	}
+
+	std::shared_ptr<const CachedLand> LandCache::find(const LandCacheKey& key)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto it = m_recent.begin(); it != m_recent.end(); it++)
+			{
+				if (sameKey(it->key, key)) {
+					m_recent.splice(m_recent.begin(), m_recent, it);
+					m_stats.memoryHits++;
+					return it->land;
+				}
+			}
+		}
+
+		// File IO happens outside the lock so other threads can still hit the memory cache
+		std::shared_ptr<const CachedLand> land = load(key);
+		if (land) {
+			remember(key, land);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stats.diskHits++;
+		}
+		return land;
+	}
+
+	std::shared_ptr<const CachedLand> LandCache::get(const LandCacheKey& key, ew::ThreadPool* pool)
+	{
+		std::shared_ptr<const CachedLand> land = find(key);
+		if (land)
+			return land;
+
+		std::shared_ptr<CachedLand> generated = std::make_shared<CachedLand>();
+		generated->m_meshData = createLand(key.size, key.subdivisions, key.seed, key.settings, pool);
+		if (key.settings.cancel && key.settings.cancel->load())
+			return nullptr;
+		generated->m_vertices = generated->m_meshData.vertices.data();
+		generated->m_numVertices = (int)generated->m_meshData.vertices.size();
+		generated->m_indices = generated->m_meshData.indices.data();
+		generated->m_numIndices = (int)generated->m_meshData.indices.size();
+		generated->m_bounds = ew::CalculateBounds(generated->m_meshData);
+		bool saved = save(key, *generated);
+		remember(key, generated);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats.misses++;
+		m_stats.diskWrites += saved ? 1 : 0;
+		return generated;
+	}
+
+	LandCacheStats LandCache::getStats()const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		LandCacheStats stats = m_stats;
+		stats.numInMemory = (int)m_recent.size();
+		return stats;
+	}
+
+	void LandCache::remember(const LandCacheKey& key, const std::shared_ptr<const CachedLand>& land)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		// Another thread may have loaded or generated the same land meanwhile
+		for (auto it = m_recent.begin(); it != m_recent.end(); it++)
+		{
+			if (sameKey(it->key, key)) {
+				m_recent.erase(it);
+				break;
+			}
+		}
+		Entry entry;
+		entry.key = key;
+		entry.key.settings.cancel = nullptr;
+		entry.land = land;
+		m_recent.push_front(entry);
+		// Lands still used by the caller stay alive through their shared_ptr
+		while ((int)m_recent.size() > m_maxInMemory)
+			m_recent.pop_back();
+	}
+
+	// One file per key, named by a hash of the header fields. Collisions are caught by the full comparison on load
+	std::string LandCache::filePath(const LandCacheKey& key)const
+	{
+		LandCacheHeader header = {};
+		writeKey(key, header);
+		const unsigned char* bytes = (const unsigned char*)&header.size;
+		const size_t numBytes = (const unsigned char*)header.boundsMin - bytes;
+		uint64_t hash = 14695981039346656037ull; // FNV-1a
+		for (size_t i = 0; i < numBytes; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "land_%016llx.bin", (unsigned long long)hash);
+		return m_directory + "/" + name;
+	}
+
+	std::shared_ptr<const CachedLand> LandCache::load(const LandCacheKey& key)const
+	{
+		if (m_directory.empty())
+			return nullptr;
+		std::shared_ptr<CachedLand> land = std::make_shared<CachedLand>();
+		if (!land->m_file.open(filePath(key)) || land->m_file.size() < sizeof(LandCacheHeader))
+			return nullptr;
+
+		LandCacheHeader header;
+		memcpy(&header, land->m_file.data(), sizeof(header));
+		LandCacheHeader expected = {};
+		writeKey(key, expected);
+		const size_t expectedSize = sizeof(LandCacheHeader) + header.numVertices * sizeof(ew::Vertex) + header.numIndices * sizeof(unsigned int);
+		if (memcmp(header.magic, "LAND", 4) != 0 || header.version != LAND_CACHE_VERSION || header.vertexSize != sizeof(ew::Vertex)
+			|| memcmp(&header.size, &expected.size, (const char*)expected.boundsMin - (const char*)&expected.size) != 0
+			|| land->m_file.size() != expectedSize) {
+			printf("Ignoring stale land cache file %s\n", filePath(key).c_str());
+			return nullptr;
+		}
+
+		const unsigned char* data = land->m_file.data() + sizeof(LandCacheHeader);
+		land->m_vertices = (const ew::Vertex*)data;
+		land->m_numVertices = (int)header.numVertices;
+		land->m_indices = (const unsigned int*)(data + header.numVertices * sizeof(ew::Vertex));
+		land->m_numIndices = (int)header.numIndices;
+		land->m_bounds.min = ew::Vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		land->m_bounds.max = ew::Vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+		return land;
+	}
+
+	// Written to a temporary file and renamed, so a crash never leaves a truncated file under the real name
+	bool LandCache::save(const LandCacheKey& key, const CachedLand& land)const
+	{
+		if (m_directory.empty())
+			return false;
+		LandCacheHeader header = {};
+		memcpy(header.magic, "LAND", 4);
+		header.version = LAND_CACHE_VERSION;
+		header.numVertices = (uint64_t)land.getNumVertices();
+		header.numIndices = (uint64_t)land.getNumIndices();
+		header.vertexSize = sizeof(ew::Vertex);
+		writeKey(key, header);
+		const ew::AABB& bounds = land.getBounds();
+		header.boundsMin[0] = bounds.min.x; header.boundsMin[1] = bounds.min.y; header.boundsMin[2] = bounds.min.z;
+		header.boundsMax[0] = bounds.max.x; header.boundsMax[1] = bounds.max.y; header.boundsMax[2] = bounds.max.z;
+
+		const std::string path = filePath(key);
+		const std::string tempPath = path + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file) {
+			printf("Failed to write land cache file %s\n", tempPath.c_str());
+			return false;
+		}
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = ok && fwrite(land.getVertices(), sizeof(ew::Vertex), land.getNumVertices(), file) == (size_t)land.getNumVertices();
+		ok = ok && fwrite(land.getIndices(), sizeof(unsigned int), land.getNumIndices(), file) == (size_t)land.getNumIndices();
+		ok = fclose(file) == 0 && ok;
+		// rename doesn't replace an existing file on Windows
+		remove(path.c_str());
+		if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+			remove(tempPath.c_str());
+			printf("Failed to write land cache file %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+}
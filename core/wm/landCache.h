@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include "../ew/mesh.h"
+#include "../ew/mappedFile.h"
+#include "procGen.h"
+
+namespace wm
+{
+	// Everything that decides what createLand returns. settings.cancel is ignored
+	struct LandCacheKey
+	{
+		float size;
+		int subdivisions;
+		int seed;
+		LandSettings settings;
+	};
+
+	// A createLand mesh held by the cache, either generated in memory or mapped straight from a cache file
+	class CachedLand
+	{
+	public:
+		// Render thread. Mapped lands go from the file pages straight to the GPU, other formats are converted first
+		inline void upload(ew::Mesh& mesh, const ew::VertexFormat& format = ew::VertexFormat())const {
+			mesh.load(m_vertices, m_numVertices, m_indices, m_numIndices, m_bounds, format);
+		}
+		// Any thread. Converts to format ahead of an ew::Mesh::load on the render thread
+		inline ew::PackedMeshData pack(const ew::VertexFormat& format)const {
+			return ew::PackMeshData(m_vertices, m_numVertices, m_indices, m_numIndices, m_bounds, format);
+		}
+		inline const ew::Vertex* getVertices()const { return m_vertices; }
+		inline int getNumVertices()const { return m_numVertices; }
+		inline const unsigned int* getIndices()const { return m_indices; }
+		inline int getNumIndices()const { return m_numIndices; }
+		inline const ew::AABB& getBounds()const { return m_bounds; }
+		inline bool isMapped()const { return m_file.isOpen(); }
+	private:
+		friend class LandCache;
+		ew::MeshData m_meshData; // generated lands own their data
+		ew::MappedFile m_file; // loaded lands point into the mapping
+		const ew::Vertex* m_vertices = nullptr;
+		int m_numVertices = 0;
+		const unsigned int* m_indices = nullptr;
+		int m_numIndices = 0;
+		ew::AABB m_bounds;
+	};
+
+	struct LandCacheStats
+	{
+		int memoryHits; // found among the recently used lands
+		int diskHits; // mapped from a cache file
+		int misses; // generated with createLand
+		int diskWrites;
+		int numInMemory;
+	};
+
+	// Remembers createLand results by every parameter that affects them. The most recent ones stay in memory and every
+	// generated land is also written to directory as one binary file (header, vertices, indices) that is memory mapped on later runs,
+	// so revisiting a seed costs a lookup or an mmap instead of the noise and normals. Safe to use from several threads.
+	class LandCache
+	{
+	public:
+		// directory is created if it doesn't exist. An empty directory keeps the cache in memory only
+		LandCache(const std::string& directory, int maxInMemory = 4);
+		LandCache(const LandCache&) = delete;
+		LandCache& operator=(const LandCache&) = delete;
+
+		// Returns the cached land or generates, stores and returns it. Returns nullptr if key.settings.cancel stopped the generation
+		std::shared_ptr<const CachedLand> get(const LandCacheKey& key, ew::ThreadPool* pool = nullptr);
+		// Returns the land if it is in memory or on disk, nullptr otherwise. Never generates
+		std::shared_ptr<const CachedLand> find(const LandCacheKey& key);
+		LandCacheStats getStats()const;
+	private:
+		struct Entry
+		{
+			LandCacheKey key;
+			std::shared_ptr<const CachedLand> land;
+		};
+
+		std::string filePath(const LandCacheKey& key)const;
+		std::shared_ptr<const CachedLand> load(const LandCacheKey& key)const;
+		bool save(const LandCacheKey& key, const CachedLand& land)const;
+		void remember(const LandCacheKey& key, const std::shared_ptr<const CachedLand>& land);
+
+		std::string m_directory;
+		int m_maxInMemory;
+
+		mutable std::mutex m_mutex;
+		std::list<Entry> m_recent; // guarded by m_mutex, most recently used first
+		LandCacheStats m_stats = {};
+	};
+}
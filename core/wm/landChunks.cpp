@@ -0,0 +1,224 @@
+#include "landChunks.h"
+#include "../ew/ewMath/transformations.h"
+#include <algorithm>
+#include <cmath>
+
+namespace wm
+{
+	// Finished chunks waiting for upload. The worker pauses at this many so a full GPU budget can't pile up CPU meshes
+	static const size_t MAX_BUILT_CHUNKS = 8;
+
+	LandChunks::LandChunks(float chunkSize, int subdivisions, int seed, int viewRadius, size_t gpuBudgetBytes, ew::ThreadPool* pool, const ew::VertexFormat& format)
+		: m_chunkSize(chunkSize), m_subdivisions(subdivisions), m_viewRadius(viewRadius), m_gpuBudgetBytes(gpuBudgetBytes), m_pool(pool),
+		m_format(format), m_seed(seed), m_workerSeed(seed), m_cancel(false)
+	{
+		m_thread = std::thread(&LandChunks::workerLoop, this);
+	}
+
+	LandChunks::~LandChunks()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cancel = true;
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	void LandChunks::setSeed(int seed)
+	{
+		if (seed == m_seed)
+			return;
+		m_seed = seed;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workerSeed = seed;
+			m_wanted.clear();
+			m_built.clear();
+			// Raised under the lock, so it can't cancel a chunk of the new seed the worker already started
+			m_cancel = true;
+		}
+		while (!m_chunks.empty())
+			evict(m_chunks.begin());
+	}
+
+	void LandChunks::update(const ew::Vec3& localCameraPosition, int maxUploads)
+	{
+		m_frame++;
+		m_centerX = (int)std::floor(localCameraPosition.x / m_chunkSize);
+		m_centerZ = (int)std::floor(-localCameraPosition.z / m_chunkSize);
+
+		// One ring of slack past the view radius so moving back and forth over a border doesn't regenerate chunks
+		int keepRadius = m_viewRadius + 1;
+		for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+			auto next = std::next(it);
+			if (std::abs(it->x - m_centerX) > keepRadius || std::abs(it->z - m_centerZ) > keepRadius)
+				evict(it);
+			it = next;
+		}
+
+		std::vector<BuiltChunk> uploads;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			// Drop finished chunks the camera has moved away from
+			m_built.erase(std::remove_if(m_built.begin(), m_built.end(), [&](const BuiltChunk& c) {
+				return std::abs(c.x - m_centerX) > keepRadius || std::abs(c.z - m_centerZ) > keepRadius;
+				}), m_built.end());
+
+			// Nearest first, but only as many as fit in the budget without evicting chunks drawn last frame
+			std::sort(m_built.begin(), m_built.end(), [&](const BuiltChunk& a, const BuiltChunk& b) {
+				return std::max(std::abs(a.x - m_centerX), std::abs(a.z - m_centerZ)) > std::max(std::abs(b.x - m_centerX), std::abs(b.z - m_centerZ));
+				});
+			while (!m_built.empty() && (int)uploads.size() < maxUploads) {
+				const ew::PackedMeshData& packed = m_built.back().packed;
+				if (!makeRoom(packed.vertices.size() + packed.indices.size()))
+					break;
+				uploads.push_back(std::move(m_built.back()));
+				m_built.pop_back();
+			}
+
+			// Requeue every missing chunk in the view radius, farthest first so the worker pops the nearest
+			m_wanted.clear();
+			for (int z = m_centerZ - m_viewRadius; z <= m_centerZ + m_viewRadius; z++) {
+				for (int x = m_centerX - m_viewRadius; x <= m_centerX + m_viewRadius; x++) {
+					uint64_t k = key(x, z);
+					if (m_chunkLookup.count(k) || (m_building && m_buildingKey == k))
+						continue;
+					bool built = false;
+					for (const BuiltChunk& c : m_built)
+						built = built || (c.x == x && c.z == z);
+					for (const BuiltChunk& c : uploads)
+						built = built || (c.x == x && c.z == z);
+					if (!built)
+						m_wanted.push_back(std::make_pair(x, z));
+				}
+			}
+			auto distanceSq = [&](const std::pair<int, int>& c) {
+				int dx = c.first - m_centerX, dz = c.second - m_centerZ;
+				return dx * dx + dz * dz;
+			};
+			std::sort(m_wanted.begin(), m_wanted.end(), [&](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+				return distanceSq(a) > distanceSq(b);
+				});
+		}
+		m_wake.notify_one();
+
+		// GL calls stay on the render thread, outside the lock
+		for (BuiltChunk& c : uploads) {
+			Chunk chunk;
+			chunk.x = c.x;
+			chunk.z = c.z;
+			chunk.mesh.reset(new ew::Mesh());
+			chunk.mesh->load(c.packed);
+			chunk.gpuBytes = chunk.mesh->getGpuBytes();
+			chunk.lastDrawnFrame = m_frame;
+			m_gpuBytes += chunk.gpuBytes;
+			m_chunks.push_front(std::move(chunk));
+			m_chunkLookup[key(c.x, c.z)] = m_chunks.begin();
+		}
+	}
+
+	// Evicts least recently drawn chunks until bytes more fit in the budget. Chunks drawn last frame are kept,
+	// so a budget smaller than the view fills up and stops instead of thrashing
+	bool LandChunks::makeRoom(size_t bytes)
+	{
+		while (m_gpuBytes + bytes > m_gpuBudgetBytes) {
+			if (m_chunks.empty() || m_chunks.back().lastDrawnFrame + 1 >= m_frame)
+				return false;
+			evict(std::prev(m_chunks.end()));
+		}
+		return true;
+	}
+
+	void LandChunks::evict(std::list<Chunk>::iterator chunk)
+	{
+		m_gpuBytes -= chunk->gpuBytes;
+		m_chunkLookup.erase(key(chunk->x, chunk->z));
+		m_chunks.erase(chunk);
+	}
+
+	void LandChunks::draw(const ew::Shader& shader, const ew::Mat4& landModel, const ew::Frustum& frustum, bool cull)
+	{
+		m_numDrawn = 0;
+		m_numCulled = 0;
+		for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+			auto next = std::next(it);
+			ew::Mat4 model = landModel * ew::Translate(ew::Vec3(it->x * m_chunkSize, 0.0f, -it->z * m_chunkSize));
+			if (cull && !ew::IsVisible(frustum, ew::TransformAABB(it->mesh->getBounds(), model))) {
+				m_numCulled++;
+			}
+			else {
+				shader.setMat4("_Model", model);
+				shader.setMat3("_NormalMatrix", ew::NormalMatrix(model));
+				it->mesh->draw();
+				it->lastDrawnFrame = m_frame;
+				m_chunks.splice(m_chunks.begin(), m_chunks, it);
+				m_numDrawn++;
+			}
+			it = next;
+		}
+	}
+
+	LandChunksStats LandChunks::getStats()const
+	{
+		LandChunksStats stats;
+		stats.numLoaded = (int)m_chunks.size();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			stats.numPending = (int)(m_wanted.size() + m_built.size()) + (m_building ? 1 : 0);
+		}
+		stats.numDrawn = m_numDrawn;
+		stats.numCulled = m_numCulled;
+		stats.gpuBytes = m_gpuBytes;
+		return stats;
+	}
+
+	void LandChunks::workerLoop()
+	{
+		LandSettings settings;
+		settings.cancel = &m_cancel;
+		while (true)
+		{
+			int x, z, seed;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_building = false;
+				m_wake.wait(lock, [&] { return m_stop || (!m_wanted.empty() && m_built.size() < MAX_BUILT_CHUNKS); });
+				if (m_stop)
+					return;
+				x = m_wanted.back().first;
+				z = m_wanted.back().second;
+				m_wanted.pop_back();
+				seed = m_workerSeed;
+				m_building = true;
+				m_buildingKey = key(x, z);
+				// Cleared under the lock so a setSeed() after this point always cancels this build
+				m_cancel = false;
+			}
+
+			// Noise is sampled at global row/column indices, so the shared edge of neighbouring chunks is bit identical
+			settings.rowOffset = z * m_subdivisions;
+			settings.colOffset = x * m_subdivisions;
+			BuiltChunk chunk;
+			chunk.x = x;
+			chunk.z = z;
+			chunk.seed = seed;
+			ew::MeshData meshData = createLand(m_chunkSize, m_subdivisions, seed, settings, m_pool);
+			if (m_cancel)
+				continue;
+			// UNORM16 positions are quantized against the same box for every chunk, not each chunk's own bounds,
+			// so the shared border vertices of neighbouring chunks still decode to the same heights. Culling keeps the tight bounds
+			const ew::AABB bounds = ew::CalculateBounds(meshData);
+			ew::AABB quantizeBounds;
+			quantizeBounds.min = ew::Vec3(0.0f, 0.0f, -m_chunkSize);
+			quantizeBounds.max = ew::Vec3(m_chunkSize, LAND_HEIGHT_SCALE, 0.0f);
+			chunk.packed = ew::PackMeshData(meshData.vertices.data(), (int)meshData.vertices.size(), meshData.indices.data(), (int)meshData.indices.size(), quantizeBounds, m_format);
+			chunk.packed.bounds = bounds;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (seed == m_workerSeed)
+				m_built.push_back(std::move(chunk));
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include "../ew/mesh.h"
+#include "../ew/shader.h"
+#include "../ew/ewMath/frustum.h"
+#include "procGen.h"
+
+namespace wm
+{
+	struct LandChunksStats
+	{
+		int numLoaded; // chunks with a GPU mesh
+		int numPending; // wanted chunks without one yet
+		int numDrawn;
+		int numCulled;
+		size_t gpuBytes; // vertex and index buffers of every loaded chunk
+	};
+
+	// Endless land made of createLand chunks streamed in around the camera.
+	// Chunk (x, z) spans world x in [x, x + 1] * chunkSize and z in [-(z + 1), -z] * chunkSize, relative to the model matrix passed to draw().
+	// Chunks are generated nearest first on a background thread (rows split across the pool) with global noise offsets, so borders are seamless.
+	// GPU meshes live in an LRU cache: chunks past the keep radius are dropped, and the least recently drawn ones go when over the memory budget.
+	class LandChunks
+	{
+	public:
+		// viewRadius: chunks in each direction around the camera's chunk that are generated and drawn
+		// format: GPU vertex layout, chunks are converted to it on the worker thread
+		LandChunks(float chunkSize, int subdivisions, int seed, int viewRadius, size_t gpuBudgetBytes, ew::ThreadPool* pool = nullptr,
+			const ew::VertexFormat& format = ew::VertexFormat());
+		~LandChunks();
+		LandChunks(const LandChunks&) = delete;
+		LandChunks& operator=(const LandChunks&) = delete;
+
+		// Drops every chunk and regenerates with the new seed
+		void setSeed(int seed);
+
+		// Render thread, once per frame: queues missing chunks around the camera (in land local space),
+		// uploads at most maxUploads finished ones and evicts far or least recently used chunks
+		void update(const ew::Vec3& localCameraPosition, int maxUploads = 2);
+
+		// Draws loaded chunks in view, or all of them when cull is false. Sets _Model and _NormalMatrix for each chunk
+		void draw(const ew::Shader& shader, const ew::Mat4& landModel, const ew::Frustum& frustum, bool cull = true);
+
+		LandChunksStats getStats()const;
+		inline float getChunkSize()const { return m_chunkSize; }
+	private:
+		struct Chunk
+		{
+			int x, z;
+			std::unique_ptr<ew::Mesh> mesh;
+			size_t gpuBytes;
+			unsigned int lastDrawnFrame;
+		};
+		struct BuiltChunk
+		{
+			int x, z;
+			int seed;
+			ew::PackedMeshData packed;
+		};
+
+		static inline uint64_t key(int x, int z) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)z; }
+		void workerLoop();
+		void evict(std::list<Chunk>::iterator chunk);
+		bool makeRoom(size_t bytes);
+
+		float m_chunkSize;
+		int m_subdivisions;
+		int m_viewRadius;
+		size_t m_gpuBudgetBytes;
+		ew::ThreadPool* m_pool;
+		ew::VertexFormat m_format;
+		int m_seed;
+
+		// Render thread only. Front of the list is the most recently drawn chunk
+		std::list<Chunk> m_chunks;
+		std::unordered_map<uint64_t, std::list<Chunk>::iterator> m_chunkLookup;
+		size_t m_gpuBytes = 0;
+		int m_centerX = 0, m_centerZ = 0;
+		int m_numDrawn = 0, m_numCulled = 0;
+		unsigned int m_frame = 0;
+
+		std::thread m_thread;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		// Guarded by m_mutex
+		std::vector<std::pair<int, int>> m_wanted; // missing chunks, nearest last so the worker pops from the back
+		std::vector<BuiltChunk> m_built; // finished, waiting for upload
+		bool m_building = false;
+		uint64_t m_buildingKey = 0;
+		int m_workerSeed;
+		std::atomic<bool> m_cancel; // raised by setSeed to abandon the chunk being built
+		bool m_stop = false;
+	};
+}
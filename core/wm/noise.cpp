@@ -0,0 +1,21 @@
+#include "noise.h"
+
+void ir::buildPermutation(unsigned int seed, uint8_t permutation[512]) {
+	for (int i = 0; i < 256; i++)
+	{
+		permutation[i] = (uint8_t)i;
+	}
+	uint32_t state = seed * 747796405u + 2891336453u;
+	for (int i = 255; i > 0; i--)
+	{
+		state = state * 1664525u + 1013904223u;
+		int j = (int)((state >> 8) % (uint32_t)(i + 1));
+		uint8_t temp = permutation[i];
+		permutation[i] = permutation[j];
+		permutation[j] = temp;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		permutation[256 + i] = permutation[i];
+	}
+}
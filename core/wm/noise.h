@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace ir {
+	// Gradient noise algorithms behind the Noise interface
+	// PERLIN: square lattice, four corners per 2D sample (eight in 3D), smoothstep interpolation
+	// SIMPLEX: triangle lattice, three corners per 2D sample (four in 3D), radial falloff. Fewer directional artifacts
+	enum class NoiseType {
+		PERLIN,
+		SIMPLEX
+	};
+
+	// Common interface of the seeded noise generators, so terrain code can switch algorithm without knowing which one it uses.
+	// The seed is fixed by each implementation's constructor. All values are roughly -1 to 1.
+	class Noise {
+	public:
+		virtual ~Noise() {}
+
+		virtual float noise2D(float x, float y) = 0;
+		virtual float noise3D(float x, float y, float z) = 0;
+		// Value plus the analytic partial derivatives d/dx and d/dy from the same evaluation
+		virtual float noise2DDerivatives(float x, float y, float& ddx, float& ddy) = 0;
+
+		// noise2D for the samples [beginX, endX) x [beginY, endY) of the grid (startX + i * stepX, startY + j * stepY), rows written outStride floats apart.
+		// Values only depend on the global sample index, so regions of one grid can be filled in any order or in parallel
+		virtual void noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) = 0;
+		// noiseRegion that also writes d/dx and d/dy of every sample, laid out like out
+		virtual void noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) = 0;
+	};
+
+	// Fills permutation with 0-255 shuffled by the seed, repeated twice so two chained lookups never need wrapping.
+	// Fisher-Yates with a fixed LCG so a seed gives the same table on every platform
+	void buildPermutation(unsigned int seed, uint8_t permutation[512]);
+}
@@ -1,9 +1,24 @@
 #include "perlinNoise.h"
+#include "../ew/ewMath/simd.h"
+#include "../ew/threadPool.h"
 
 // Isabel Rowland
 
-ir::PerlinNoise::PerlinNoise(unsigned int seed) {
-	// Having the seed here is pointless it's just a default constructor
+ir::PerlinNoise::PerlinNoise() : PerlinNoise(0) {
+}
+
+ir::PerlinNoise::PerlinNoise(unsigned int seed, Mode mode) : m_mode(mode), m_seed(seed) {
+	buildTables(seed);
+}
+
+// Shuffles the permutation table with the seed and fills the gradient table, once per noise object
+void ir::PerlinNoise::buildTables(unsigned int seed) {
+	for (int i = 0; i < TABLE_SIZE; i++)
+	{
+		float angle = ew::TAU * i / TABLE_SIZE;
+		m_gradients[i] = ew::Vec2(cos(angle), sin(angle));
+	}
+	buildPermutation(seed, m_permutation);
 }
 
 // Interpolate between two values for smoothness, etc.
@@ -30,7 +45,7 @@ ew::Vec2 ir::PerlinNoise::randomGrad(int ix, int iy, unsigned int seed) {
 
 // Dot product of the gradient and the grid values
 float ir::PerlinNoise::dotGridGrad(int ix, int iy, float x, float y, unsigned int seed) {
-	ew::Vec2 grad = randomGrad(ix, iy, seed);
+	ew::Vec2 grad = latticeGrad(ix, iy, seed);
 	float dx = x - (float)ix;
 	float dy = y - (float)iy;
 
@@ -63,4 +78,380 @@ float ir::PerlinNoise::noiseGen(float x, float y, unsigned int seed) {
 
 	value = interpolate(ix0, ix1, sy);
 	return value; // from -1 to 1
-}
\ No newline at end of file
+}
+
+// Dot product of one of the 12 cube edge directions, picked by the low bits of hash, with (x, y, z)
+static inline float edgeGradDot(int hash, float x, float y, float z) {
+	switch (hash % 12) {
+	case 0: return x + y;
+	case 1: return -x + y;
+	case 2: return x - y;
+	case 3: return -x - y;
+	case 4: return x + z;
+	case 5: return -x + z;
+	case 6: return x - z;
+	case 7: return -x - z;
+	case 8: return y + z;
+	case 9: return -y + z;
+	case 10: return y - z;
+	default: return -y - z;
+	}
+}
+
+float ir::PerlinNoise::noiseGen3D(float x, float y, float z) {
+	int x0 = (int)floor(x);
+	int y0 = (int)floor(y);
+	int z0 = (int)floor(z);
+	float sx = x - (float)x0;
+	float sy = y - (float)y0;
+	float sz = z - (float)z0;
+	const int ix = x0 & (TABLE_SIZE - 1), iy = y0 & (TABLE_SIZE - 1), iz = z0 & (TABLE_SIZE - 1);
+	// Hash of a corner: permutation chained over x, y, z
+	auto hash = [&](int cx, int cy, int cz) {
+		return m_permutation[m_permutation[m_permutation[ix + cx] + iy + cy] + iz + cz];
+	};
+
+	float x00 = interpolate(edgeGradDot(hash(0, 0, 0), sx, sy, sz), edgeGradDot(hash(1, 0, 0), sx - 1.0f, sy, sz), sx);
+	float x10 = interpolate(edgeGradDot(hash(0, 1, 0), sx, sy - 1.0f, sz), edgeGradDot(hash(1, 1, 0), sx - 1.0f, sy - 1.0f, sz), sx);
+	float x01 = interpolate(edgeGradDot(hash(0, 0, 1), sx, sy, sz - 1.0f), edgeGradDot(hash(1, 0, 1), sx - 1.0f, sy, sz - 1.0f), sx);
+	float x11 = interpolate(edgeGradDot(hash(0, 1, 1), sx, sy - 1.0f, sz - 1.0f), edgeGradDot(hash(1, 1, 1), sx - 1.0f, sy - 1.0f, sz - 1.0f), sx);
+	return interpolate(interpolate(x00, x10, sy), interpolate(x01, x11, sy), sz);
+}
+
+// Value and partial derivatives at one point, same lattice and weights as noiseGen
+float ir::PerlinNoise::noiseGenDerivatives(float x, float y, unsigned int seed, float& ddx, float& ddy) {
+	int x0 = (int)floor(x);
+	int y0 = (int)floor(y);
+	float sx = x - (float)x0;
+	float sy = y - (float)y0;
+	ew::Vec2 g00 = latticeGrad(x0, y0, seed);
+	ew::Vec2 g10 = latticeGrad(x0 + 1, y0, seed);
+	ew::Vec2 g01 = latticeGrad(x0, y0 + 1, seed);
+	ew::Vec2 g11 = latticeGrad(x0 + 1, y0 + 1, seed);
+
+	// Corner dot products
+	float n00 = sx * g00.x + sy * g00.y;
+	float n10 = (sx - 1.0f) * g10.x + sy * g10.y;
+	float n01 = sx * g01.x + (sy - 1.0f) * g01.y;
+	float n11 = (sx - 1.0f) * g11.x + (sy - 1.0f) * g11.y;
+	// Smoothstep weights and their slopes
+	float u = (3.0f - sx * 2.0f) * sx * sx, du = 6.0f * sx * (1.0f - sx);
+	float v = (3.0f - sy * 2.0f) * sy * sy, dv = 6.0f * sy * (1.0f - sy);
+
+	float ix0 = n00 + u * (n10 - n00);
+	float ix1 = n01 + u * (n11 - n01);
+	float ix0dx = g00.x + du * (n10 - n00) + u * (g10.x - g00.x);
+	float ix1dx = g01.x + du * (n11 - n01) + u * (g11.x - g01.x);
+	float ix0dy = g00.y + u * (g10.y - g00.y);
+	float ix1dy = g01.y + u * (g11.y - g01.y);
+	ddx = ix0dx + v * (ix1dx - ix0dx);
+	ddy = ix0dy + dv * (ix1 - ix0) + v * (ix1dy - ix0dy);
+	return ix0 + v * (ix1 - ix0);
+}
+
+// Row-coherent grid version of noiseGen - every row of the grid shares its x coordinates, so the
+// cell index, offset into the cell and fade weight along x are computed once for the whole region.
+// Samples are grouped into runs that fall in the same cell, which share their four corner gradients.
+// Coordinates come from the global sample index, so a sample has the same value whichever region it is evaluated in.
+// DERIVATIVES also writes d/dx and d/dy, the same expressions as noiseGenDerivatives.
+template<bool DERIVATIVES>
+static void evaluateRegion(ir::PerlinNoise& perlin, float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY, unsigned int seed) {
+	const int numX = endX - beginX;
+	if (numX <= 0 || endY <= beginY)
+		return;
+
+	// Per column: offset into its cell, the interpolation weight and its slope
+	std::vector<float> dxs(numX), fadeXs(numX), slopeXs(DERIVATIVES ? numX : 0);
+	// Runs of columns inside the same cell: [runStarts[r], runStarts[r + 1]) is in cell runCells[r]
+	std::vector<int> runStarts, runCells;
+	for (int i = 0; i < numX; i++)
+	{
+		float x = startX + (beginX + i) * stepX;
+		int cell = (int)floor(x);
+		float dx = x - (float)cell;
+		dxs[i] = dx;
+		fadeXs[i] = (3.0f - dx * 2.0f) * dx * dx;
+		if (DERIVATIVES)
+			slopeXs[i] = 6.0f * dx * (1.0f - dx);
+		if (runCells.empty() || runCells.back() != cell) {
+			runStarts.push_back(i);
+			runCells.push_back(cell);
+		}
+	}
+	runStarts.push_back(numX);
+	int minCell = runCells[0], maxCell = runCells[0];
+	for (int cell : runCells)
+	{
+		minCell = cell < minCell ? cell : minCell;
+		maxCell = cell > maxCell ? cell : maxCell;
+	}
+
+	// Gradients of the two lattice rows around the current sample row, indexed by cell - minCell
+	const int numCorners = maxCell - minCell + 2;
+	std::vector<ew::Vec2> grads0(numCorners), grads1(numCorners);
+	int lattice0 = 0;
+	bool haveLattice = false;
+	auto fillLatticeRow = [&](std::vector<ew::Vec2>& grads, int iy) {
+		for (int k = 0; k < numCorners; k++)
+		{
+			grads[k] = perlin.latticeGrad(minCell + k, iy, seed);
+		}
+	};
+
+	for (int j = beginY; j < endY; j++)
+	{
+		float y = startY + j * stepY;
+		int y0 = (int)floor(y);
+		if (!haveLattice || y0 != lattice0) {
+			// Moving up one lattice row reuses the old top row as the new bottom row
+			if (haveLattice && y0 == lattice0 + 1) {
+				grads0.swap(grads1);
+			}
+			else {
+				fillLatticeRow(grads0, y0);
+			}
+			fillLatticeRow(grads1, y0 + 1);
+			lattice0 = y0;
+			haveLattice = true;
+		}
+		const float dy0 = y - (float)y0;
+		const float dy1 = y - (float)(y0 + 1);
+		const float fadeY = (3.0f - dy0 * 2.0f) * dy0 * dy0;
+		const float slopeY = 6.0f * dy0 * (1.0f - dy0);
+		const size_t rowOffset = (size_t)(j - beginY) * outStride;
+		float* row = out + rowOffset;
+		float* rowDdx = DERIVATIVES ? outDdx + rowOffset : nullptr;
+		float* rowDdy = DERIVATIVES ? outDdy + rowOffset : nullptr;
+
+		for (size_t r = 0; r < runCells.size(); r++)
+		{
+			const int k = runCells[r] - minCell;
+			// The y part of each corner's dot product is constant along the run
+			const float g00x = grads0[k].x, g00y = grads0[k].y, c00 = dy0 * g00y;
+			const float g10x = grads0[k + 1].x, g10y = grads0[k + 1].y, c10 = dy0 * g10y;
+			const float g01x = grads1[k].x, g01y = grads1[k].y, c01 = dy1 * g01y;
+			const float g11x = grads1[k + 1].x, g11y = grads1[k + 1].y, c11 = dy1 * g11y;
+			int i = runStarts[r];
+			const int end = runStarts[r + 1];
+#if defined(EW_SIMD_AVX)
+			{
+				const __m256 vg00x = _mm256_set1_ps(g00x), vc00 = _mm256_set1_ps(c00);
+				const __m256 vg10x = _mm256_set1_ps(g10x), vc10 = _mm256_set1_ps(c10);
+				const __m256 vg01x = _mm256_set1_ps(g01x), vc01 = _mm256_set1_ps(c01);
+				const __m256 vg11x = _mm256_set1_ps(g11x), vc11 = _mm256_set1_ps(c11);
+				const __m256 one = _mm256_set1_ps(1.0f), vFadeY = _mm256_set1_ps(fadeY), vSlopeY = _mm256_set1_ps(slopeY);
+				const __m256 vg00y = _mm256_set1_ps(g00y), vg01y = _mm256_set1_ps(g01y);
+				const __m256 vdgx0 = _mm256_set1_ps(g10x - g00x), vdgx1 = _mm256_set1_ps(g11x - g01x);
+				const __m256 vdgy0 = _mm256_set1_ps(g10y - g00y), vdgy1 = _mm256_set1_ps(g11y - g01y);
+				for (; i + 8 <= end; i += 8)
+				{
+					const __m256 dx = _mm256_loadu_ps(&dxs[i]);
+					const __m256 dx1 = _mm256_sub_ps(dx, one);
+					const __m256 u = _mm256_loadu_ps(&fadeXs[i]);
+					const __m256 n00 = _mm256_add_ps(_mm256_mul_ps(dx, vg00x), vc00);
+					const __m256 n10 = _mm256_add_ps(_mm256_mul_ps(dx1, vg10x), vc10);
+					const __m256 n01 = _mm256_add_ps(_mm256_mul_ps(dx, vg01x), vc01);
+					const __m256 n11 = _mm256_add_ps(_mm256_mul_ps(dx1, vg11x), vc11);
+					const __m256 a = _mm256_sub_ps(n10, n00), b = _mm256_sub_ps(n11, n01);
+					const __m256 ix0 = _mm256_add_ps(_mm256_mul_ps(a, u), n00);
+					const __m256 ix1 = _mm256_add_ps(_mm256_mul_ps(b, u), n01);
+					_mm256_storeu_ps(row + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(ix1, ix0), vFadeY), ix0));
+					if (DERIVATIVES) {
+						const __m256 du = _mm256_loadu_ps(&slopeXs[i]);
+						const __m256 ix0dx = _mm256_add_ps(_mm256_add_ps(vg00x, _mm256_mul_ps(du, a)), _mm256_mul_ps(u, vdgx0));
+						const __m256 ix1dx = _mm256_add_ps(_mm256_add_ps(vg01x, _mm256_mul_ps(du, b)), _mm256_mul_ps(u, vdgx1));
+						const __m256 ix0dy = _mm256_add_ps(vg00y, _mm256_mul_ps(u, vdgy0));
+						const __m256 ix1dy = _mm256_add_ps(vg01y, _mm256_mul_ps(u, vdgy1));
+						_mm256_storeu_ps(rowDdx + i, _mm256_add_ps(ix0dx, _mm256_mul_ps(vFadeY, _mm256_sub_ps(ix1dx, ix0dx))));
+						_mm256_storeu_ps(rowDdy + i, _mm256_add_ps(_mm256_add_ps(ix0dy, _mm256_mul_ps(vSlopeY, _mm256_sub_ps(ix1, ix0))), _mm256_mul_ps(vFadeY, _mm256_sub_ps(ix1dy, ix0dy))));
+					}
+				}
+			}
+#endif
+#if defined(EW_SIMD_SSE)
+			{
+				const __m128 vg00x = _mm_set1_ps(g00x), vc00 = _mm_set1_ps(c00);
+				const __m128 vg10x = _mm_set1_ps(g10x), vc10 = _mm_set1_ps(c10);
+				const __m128 vg01x = _mm_set1_ps(g01x), vc01 = _mm_set1_ps(c01);
+				const __m128 vg11x = _mm_set1_ps(g11x), vc11 = _mm_set1_ps(c11);
+				const __m128 one = _mm_set1_ps(1.0f), vFadeY = _mm_set1_ps(fadeY), vSlopeY = _mm_set1_ps(slopeY);
+				const __m128 vg00y = _mm_set1_ps(g00y), vg01y = _mm_set1_ps(g01y);
+				const __m128 vdgx0 = _mm_set1_ps(g10x - g00x), vdgx1 = _mm_set1_ps(g11x - g01x);
+				const __m128 vdgy0 = _mm_set1_ps(g10y - g00y), vdgy1 = _mm_set1_ps(g11y - g01y);
+				for (; i + 4 <= end; i += 4)
+				{
+					const __m128 dx = _mm_loadu_ps(&dxs[i]);
+					const __m128 dx1 = _mm_sub_ps(dx, one);
+					const __m128 u = _mm_loadu_ps(&fadeXs[i]);
+					const __m128 n00 = _mm_add_ps(_mm_mul_ps(dx, vg00x), vc00);
+					const __m128 n10 = _mm_add_ps(_mm_mul_ps(dx1, vg10x), vc10);
+					const __m128 n01 = _mm_add_ps(_mm_mul_ps(dx, vg01x), vc01);
+					const __m128 n11 = _mm_add_ps(_mm_mul_ps(dx1, vg11x), vc11);
+					const __m128 a = _mm_sub_ps(n10, n00), b = _mm_sub_ps(n11, n01);
+					const __m128 ix0 = _mm_add_ps(_mm_mul_ps(a, u), n00);
+					const __m128 ix1 = _mm_add_ps(_mm_mul_ps(b, u), n01);
+					_mm_storeu_ps(row + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(ix1, ix0), vFadeY), ix0));
+					if (DERIVATIVES) {
+						const __m128 du = _mm_loadu_ps(&slopeXs[i]);
+						const __m128 ix0dx = _mm_add_ps(_mm_add_ps(vg00x, _mm_mul_ps(du, a)), _mm_mul_ps(u, vdgx0));
+						const __m128 ix1dx = _mm_add_ps(_mm_add_ps(vg01x, _mm_mul_ps(du, b)), _mm_mul_ps(u, vdgx1));
+						const __m128 ix0dy = _mm_add_ps(vg00y, _mm_mul_ps(u, vdgy0));
+						const __m128 ix1dy = _mm_add_ps(vg01y, _mm_mul_ps(u, vdgy1));
+						_mm_storeu_ps(rowDdx + i, _mm_add_ps(ix0dx, _mm_mul_ps(vFadeY, _mm_sub_ps(ix1dx, ix0dx))));
+						_mm_storeu_ps(rowDdy + i, _mm_add_ps(_mm_add_ps(ix0dy, _mm_mul_ps(vSlopeY, _mm_sub_ps(ix1, ix0))), _mm_mul_ps(vFadeY, _mm_sub_ps(ix1dy, ix0dy))));
+					}
+				}
+			}
+#endif
+			// Remainder, and the whole run without SIMD
+			for (; i < end; i++)
+			{
+				const float dx = dxs[i];
+				const float u = fadeXs[i];
+				const float n00 = dx * g00x + c00;
+				const float n10 = (dx - 1.0f) * g10x + c10;
+				const float n01 = dx * g01x + c01;
+				const float n11 = (dx - 1.0f) * g11x + c11;
+				const float a = n10 - n00, b = n11 - n01;
+				const float ix0 = a * u + n00;
+				const float ix1 = b * u + n01;
+				row[i] = (ix1 - ix0) * fadeY + ix0;
+				if (DERIVATIVES) {
+					const float du = slopeXs[i];
+					const float ix0dx = (g00x + du * a) + u * (g10x - g00x);
+					const float ix1dx = (g01x + du * b) + u * (g11x - g01x);
+					const float ix0dy = g00y + u * (g10y - g00y);
+					const float ix1dy = g01y + u * (g11y - g01y);
+					rowDdx[i] = ix0dx + fadeY * (ix1dx - ix0dx);
+					rowDdy[i] = (ix0dy + slopeY * (ix1 - ix0)) + fadeY * (ix1dy - ix0dy);
+				}
+			}
+		}
+	}
+}
+
+void ir::PerlinNoise::noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY, unsigned int seed) {
+	evaluateRegion<false>(*this, out, nullptr, nullptr, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY, seed);
+}
+
+void ir::PerlinNoise::noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY, unsigned int seed) {
+	evaluateRegion<true>(*this, out, outDdx, outDdy, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY, seed);
+}
+
+void ir::PerlinNoise::noiseGrid(float* out, int numX, int numY, float startX, float startY, float stepX, float stepY, unsigned int seed) {
+	noiseRegion(out, numX > 0 ? numX : 0, 0, numX, 0, numY, startX, startY, stepX, stepY, seed);
+}
+
+std::vector<float> ir::PerlinNoise::noiseGrid(int numX, int numY, float startX, float startY, float stepX, float stepY, unsigned int seed) {
+	std::vector<float> heights(numX > 0 && numY > 0 ? (size_t)numX * numY : 0);
+	noiseGrid(heights.data(), numX, numY, startX, startY, stepX, stepY, seed);
+	return heights;
+}
+
+// Each octave samples its own seed, m_seed + octave, so octaves read the tables in different orders.
+// They are also shifted so lattice points of different octaves don't line up (they would all be 0 at the same spots)
+static const float OCTAVE_OFFSET = 17.37f;
+// Tiles are square blocks of samples, small enough that an octave's scratch buffer stays in cache
+static const int FRACTAL_TILE_SIZE = 64;
+
+float ir::PerlinNoise::fractalNoise(float x, float y, const FractalSettings& settings) {
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	float sum = 0.0f, totalAmplitude = 0.0f;
+	for (int octave = 0; octave < settings.octaves; octave++)
+	{
+		float offset = octave * OCTAVE_OFFSET;
+		float n = noiseGen(x * frequency + offset, y * frequency + offset, m_seed + octave);
+		if (settings.type == FractalType::RIDGED) {
+			n = 1.0f - fabsf(n);
+			n *= n;
+		}
+		sum += n * amplitude;
+		totalAmplitude += amplitude;
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+	return totalAmplitude > 0.0f ? sum / totalAmplitude : 0.0f;
+}
+
+void ir::PerlinNoise::fractalGrid(float* out, int numX, int numY, float startX, float startY, float stepX, float stepY, const FractalSettings& settings, ew::ThreadPool* pool) {
+	if (numX <= 0 || numY <= 0)
+		return;
+	const int tilesX = (numX + FRACTAL_TILE_SIZE - 1) / FRACTAL_TILE_SIZE;
+	const int tilesY = (numY + FRACTAL_TILE_SIZE - 1) / FRACTAL_TILE_SIZE;
+
+	float totalAmplitude = 0.0f;
+	float weight = 1.0f;
+	for (int octave = 0; octave < settings.octaves; octave++)
+	{
+		totalAmplitude += weight;
+		weight *= settings.gain;
+	}
+	const float scale = totalAmplitude > 0.0f ? 1.0f / totalAmplitude : 0.0f;
+
+	auto generateTile = [&](size_t tile) {
+		const int beginX = (int)(tile % tilesX) * FRACTAL_TILE_SIZE;
+		const int beginY = (int)(tile / tilesX) * FRACTAL_TILE_SIZE;
+		const int endX = beginX + FRACTAL_TILE_SIZE < numX ? beginX + FRACTAL_TILE_SIZE : numX;
+		const int endY = beginY + FRACTAL_TILE_SIZE < numY ? beginY + FRACTAL_TILE_SIZE : numY;
+		const int width = endX - beginX;
+		float octaveValues[FRACTAL_TILE_SIZE * FRACTAL_TILE_SIZE];
+		float sums[FRACTAL_TILE_SIZE * FRACTAL_TILE_SIZE] = {};
+
+		float frequency = settings.frequency;
+		float amplitude = 1.0f;
+		for (int octave = 0; octave < settings.octaves; octave++)
+		{
+			float offset = octave * OCTAVE_OFFSET;
+			noiseRegion(octaveValues, FRACTAL_TILE_SIZE, beginX, endX, beginY, endY,
+				startX * frequency + offset, startY * frequency + offset, stepX * frequency, stepY * frequency, m_seed + octave);
+			for (int j = 0; j < endY - beginY; j++)
+			{
+				const float* values = octaveValues + j * FRACTAL_TILE_SIZE;
+				float* row = sums + j * FRACTAL_TILE_SIZE;
+				if (settings.type == FractalType::RIDGED) {
+					for (int i = 0; i < width; i++)
+					{
+						float n = 1.0f - fabsf(values[i]);
+						row[i] += n * n * amplitude;
+					}
+				}
+				else {
+					for (int i = 0; i < width; i++)
+					{
+						row[i] += values[i] * amplitude;
+					}
+				}
+			}
+			frequency *= settings.lacunarity;
+			amplitude *= settings.gain;
+		}
+
+		for (int j = 0; j < endY - beginY; j++)
+		{
+			float* dst = out + (size_t)(beginY + j) * numX + beginX;
+			const float* row = sums + j * FRACTAL_TILE_SIZE;
+			for (int i = 0; i < width; i++)
+			{
+				dst[i] = row[i] * scale;
+			}
+		}
+	};
+
+	const size_t numTiles = (size_t)tilesX * tilesY;
+	if (pool) {
+		pool->parallelFor(numTiles, generateTile);
+	}
+	else {
+		for (size_t tile = 0; tile < numTiles; tile++)
+		{
+			generateTile(tile);
+		}
+	}
+}
+
+std::vector<float> ir::PerlinNoise::fractalGrid(int numX, int numY, float startX, float startY, float stepX, float stepY, const FractalSettings& settings, ew::ThreadPool* pool) {
+	std::vector<float> heights(numX > 0 && numY > 0 ? (size_t)numX * numY : 0);
+	fractalGrid(heights.data(), numX, numY, startX, startY, stepX, stepY, settings, pool);
+	return heights;
+}
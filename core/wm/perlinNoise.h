@@ -1,19 +1,105 @@
 #pragma once
 #include "../ew/ewMath/ewMath.h"
 #include "math.h"
+#include "noise.h"
+#include <vector>
+#include <cstdint>
+
+namespace ew {
+	class ThreadPool;
+}
 
 // Isabel Rowland
 namespace ir {
-	class PerlinNoise {
+	enum class FractalType {
+		FBM, // Sum of octaves, roughly -1 to 1
+		RIDGED // Sum of squared (1 - |octave|), sharp crests, 0 to 1
+	};
+
+	// Multi-octave noise settings. Octave i samples seed + i at frequency * lacunarity^i with weight gain^i
+	struct FractalSettings {
+		FractalType type = FractalType::FBM;
+		int octaves = 6;
+		float frequency = 1.0f;
+		float lacunarity = 2.0f;
+		float gain = 0.5f;
+	};
+
+	class PerlinNoise : public Noise {
+	public:
+		// How lattice gradients are picked
+		// TABLE: seeded permutation and gradient tables built once by the constructor, lookups only while sampling
+		// LEGACY_HASH: the original per-corner hash and cos/sin, reproduces terrain generated before the tables existed
+		enum class Mode {
+			TABLE,
+			LEGACY_HASH
+		};
 	private:
+		static const int TABLE_SIZE = 256;
+
 		float gradient(float x, float y, float z, int hash); // never used mb
 		float fade(float t);
+		void buildTables(unsigned int seed);
+
+		Mode m_mode;
+		unsigned int m_seed;
+		uint8_t m_permutation[TABLE_SIZE * 2]; // Shuffled 0-255 twice so two lookups never need wrapping
+		ew::Vec2 m_gradients[TABLE_SIZE]; // Unit gradients evenly spaced around the circle
 	public:
 		PerlinNoise(); // Default constructor
-		PerlinNoise(unsigned int seed);
+		PerlinNoise(unsigned int seed, Mode mode = Mode::TABLE);
+		inline Mode getMode()const { return m_mode; }
+		inline unsigned int getSeed()const { return m_seed; }
+
+		// In TABLE mode the constructor's seed reads the tables as built, any other seed reads them in a different order (see latticeGrad)
 		float noiseGen(float x, float y, unsigned int seed);
+		inline float noiseGen(float x, float y) { return noiseGen(x, y, m_seed); }
+		// 3D Perlin noise on the permutation table with the 12 cube edge gradients, both modes
+		float noiseGen3D(float x, float y, float z);
 		float interpolate(float a, float b, float w);
 		ew::Vec2 randomGrad(int ix, int iy, unsigned int seed);
 		float dotGridGrad(int ix, int iy, float x, float y, unsigned int seed);
+
+		// Gradient at a lattice point for the current mode
+		// TABLE mode XORs a hash of seed ^ getSeed() into both permutation lookups and the gradient index, which is 0 for the constructor's seed
+		inline ew::Vec2 latticeGrad(int ix, int iy, unsigned int seed) {
+			if (m_mode == Mode::LEGACY_HASH)
+				return randomGrad(ix, iy, seed);
+			uint32_t h = (seed ^ m_seed) * 0x9E3779B9u;
+			int sx = h >> 24, sy = (h >> 16) & (TABLE_SIZE - 1), sg = (h >> 8) & (TABLE_SIZE - 1);
+			return m_gradients[m_permutation[m_permutation[(ix & (TABLE_SIZE - 1)) ^ sx] + ((iy & (TABLE_SIZE - 1)) ^ sy)] ^ sg];
+		}
+
+		// Evaluates noiseGen over a regular grid in one call: out[j * numX + i] = noiseGen(startX + i * stepX, startY + j * stepY, seed)
+		// Lattice gradients are computed once per grid cell and shared by every sample inside it, samples along x are done 4/8 at a time
+		// Matches noiseGen within float rounding
+		void noiseGrid(float* out, int numX, int numY, float startX, float startY, float stepX, float stepY, unsigned int seed);
+		std::vector<float> noiseGrid(int numX, int numY, float startX, float startY, float stepX, float stepY, unsigned int seed);
+		// noiseGrid for the samples [beginX, endX) x [beginY, endY) of a larger grid, rows written outStride floats apart
+		// Values only depend on the global sample index, so regions of one grid can be filled in any order or in parallel
+		void noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY, unsigned int seed);
+
+		// Value plus the analytic partial derivatives d/dx and d/dy from the same evaluation
+		float noiseGenDerivatives(float x, float y, unsigned int seed, float& ddx, float& ddy);
+		// noiseRegion that also writes d/dx and d/dy of every sample, laid out like out
+		void noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY, unsigned int seed);
+
+		// Noise interface, sampled with the constructor's seed
+		float noise2D(float x, float y) override { return noiseGen(x, y, m_seed); }
+		float noise3D(float x, float y, float z) override { return noiseGen3D(x, y, z); }
+		float noise2DDerivatives(float x, float y, float& ddx, float& ddy) override { return noiseGenDerivatives(x, y, m_seed, ddx, ddy); }
+		void noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) override {
+			noiseRegion(out, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY, m_seed);
+		}
+		void noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) override {
+			noiseRegionDerivatives(out, outDdx, outDdy, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY, m_seed);
+		}
+
+		// Multi-octave noise at one point, normalized by the total octave weight
+		float fractalNoise(float x, float y, const FractalSettings& settings);
+		// fractalNoise over a grid, same layout as noiseGrid. The grid is split into fixed size tiles that are spread over the pool,
+		// every sample's value only depends on its grid index so the output is identical for any thread count. No pool runs on the caller.
+		void fractalGrid(float* out, int numX, int numY, float startX, float startY, float stepX, float stepY, const FractalSettings& settings, ew::ThreadPool* pool = nullptr);
+		std::vector<float> fractalGrid(int numX, int numY, float startX, float startY, float stepX, float stepY, const FractalSettings& settings, ew::ThreadPool* pool = nullptr);
 	};
 }
\ No newline at end of file
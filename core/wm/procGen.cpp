@@ -1,7 +1,12 @@
 #pragma once
 #include "procGen.h"
+#include "../ew/threadPool.h"
+#include "simplexNoise.h"
 namespace wm
 {
+	// Rows of land generated by one task. Fixed so the work split never depends on the thread count
+	static const int LAND_ROWS_PER_BAND = 16;
+
 	ew::MeshData createPlane(float size, int subdivisions)
 	{
 		ew::MeshData plane;
@@ -316,158 +321,127 @@ namespace wm
 	}
 
 	// Making the randomly generated land - Isabel Rowland
-	ew::MeshData createLand(float size, int subdivisions, int seed)
+	// Rows are processed in fixed bands, each band only writes its own vertices and indices, so the
+	// result is the same for any number of threads
+	ew::MeshData createLand(float size, int subdivisions, int seed, const LandSettings& settings, ew::ThreadPool* pool)
 	{
 		ew::MeshData plane;
 		float width = size;
 		float height = size;
-		ir::PerlinNoise perlin = ir::PerlinNoise::PerlinNoise(seed); // Makes a perlin noise variable
+		ir::PerlinNoise perlin(seed, settings.noiseMode); // Makes a perlin noise variable
+		ir::SimplexNoise simplex(seed);
+		ir::Noise& noise = settings.noise == ir::NoiseType::SIMPLEX ? static_cast<ir::Noise&>(simplex) : perlin;
+		const int numVertices = subdivisions + 1; // per row and per column
+		const float noiseStep = 0.01f; // noise space distance between vertices
+		const float heightScale = LAND_HEIGHT_SCALE;
+		const bool analyticNormals = settings.normals == LandNormals::ANALYTIC;
+		// Chain rule from noise space to object space: height = (n + 1) * 0.5 * heightScale, col = x * subdivisions / width, row = -z * subdivisions / height
+		const float slopeX = 0.5f * heightScale * noiseStep * subdivisions / width;
+		const float slopeZ = -0.5f * heightScale * noiseStep * subdivisions / height;
+		plane.vertices.resize((size_t)numVertices * numVertices);
+		plane.indices.resize((size_t)subdivisions * subdivisions * 6);
+		const int numBands = (numVertices + LAND_ROWS_PER_BAND - 1) / LAND_ROWS_PER_BAND;
+
+		// Heights, vertices (with analytic normals) and the indices of the quads below each row
+		auto buildRows = [&](size_t band) {
+			const int beginRow = (int)band * LAND_ROWS_PER_BAND;
+			const int endRow = beginRow + LAND_ROWS_PER_BAND < numVertices ? beginRow + LAND_ROWS_PER_BAND : numVertices;
+			const int bandRows = endRow - beginRow;
+			if (settings.cancel && settings.cancel->load(std::memory_order_relaxed))
+				return;
+			// Noise of this band only: sample ((rowOffset + row) * 0.01, (colOffset + col) * 0.01) lands at heights[col * bandRows + row - beginRow], derivatives at the same index
+			std::vector<float> bandNoise((size_t)(analyticNormals ? 3 : 1) * bandRows * numVertices);
+			float* heights = bandNoise.data();
+			float* ddRow = heights + (size_t)bandRows * numVertices;
+			float* ddCol = ddRow + (size_t)bandRows * numVertices;
+			if (analyticNormals) {
+				noise.noiseRegionDerivatives(heights, ddRow, ddCol, bandRows, settings.rowOffset + beginRow, settings.rowOffset + endRow,
+					settings.colOffset, settings.colOffset + numVertices, 0.0f, 0.0f, noiseStep, noiseStep);
+			}
+			else {
+				noise.noiseRegion(heights, bandRows, settings.rowOffset + beginRow, settings.rowOffset + endRow,
+					settings.colOffset, settings.colOffset + numVertices, 0.0f, 0.0f, noiseStep, noiseStep);
+			}
 
-		//vertex
-		for (int row = 0; row <= subdivisions; row++)
-		{
-			for (int col = 0; col <= subdivisions; col++)
+			for (int row = beginRow; row < endRow; row++)
 			{
-				ew::Vertex vertex;
-				float colSub = static_cast<float>(col) / subdivisions;
-				float rowSub = static_cast<float>(row) / subdivisions;
-
-				float n = perlin.noiseGen(row * 0.01, col * 0.01, seed); // generates the noise with a given seed
-				n += 1.0; // setting the generated value from 0 to 1 instead of -1 to 1
-				n *= 0.5;
-				vertex.pos.y = n * 10; // making the y values bigger
-				
-				vertex.pos.x = width * colSub;
-				
-				vertex.pos.z = -height * rowSub;
-
-				//normals
-				vertex.normal = ew::Vec3(0, 1, 0);
-				//UVs
-				vertex.uv = ew::Vec2(colSub, rowSub);
+				for (int col = 0; col <= subdivisions; col++)
+				{
+					ew::Vertex& vertex = plane.vertices[row * numVertices + col];
+					float colSub = static_cast<float>(col) / subdivisions;
+					float rowSub = static_cast<float>(row) / subdivisions;
+
+					const int sample = col * bandRows + row - beginRow;
+					float n = heights[sample]; // the noise with the given seed
+					n += 1.0; // setting the generated value from 0 to 1 instead of -1 to 1
+					n *= 0.5;
+					vertex.pos.y = n * heightScale; // making the y values bigger
+					vertex.pos.x = width * colSub;
+					vertex.pos.z = -height * rowSub;
+					//UVs
+					vertex.uv = ew::Vec2(colSub, rowSub);
+					// Surface y = h(x, z) has normal (-dh/dx, 1, -dh/dz), exact on the borders too
+					if (analyticNormals) {
+						float dhdx = ddCol[sample] * slopeX;
+						float dhdz = ddRow[sample] * slopeZ;
+						vertex.normal = ew::Normalize(ew::Vec3(-dhdx, 1.0f, -dhdz));
+					}
+				}
 
-				plane.vertices.push_back(vertex);
+				//indecies
+				if (row == subdivisions)
+					continue;
+				unsigned int* index = &plane.indices[(size_t)row * subdivisions * 6];
+				for (int col = 0; col < subdivisions; col++)
+				{
+					unsigned int start = row * numVertices + col;
+					//bottom triangle
+					*index++ = start;
+					*index++ = start + 1;
+					*index++ = start + numVertices + 1;
+					//top triangle
+					*index++ = start;
+					*index++ = start + numVertices + 1;
+					*index++ = start + numVertices;
+				}
 			}
-		}
+		};
 
 		// Setting normals - Isabel Rowland with math help from Will
-		for (int row = 0; row <= subdivisions; row++) {
-			for (int col = 0; col <= subdivisions; col++) {
-				ew::Vec3 middle = plane.vertices[row * subdivisions + col].pos; // the point in question
-				bool isRight, isUp, isLeft, isDown; // do all the vectors exist (is it on an edge or not)
-				ew::Vec3 top, left, right, bottom; // the vertex positions above, below, to the left, and to the right of the point
-				
-				// Gathering the positional data of the vertices above, below, left, and right
-				if (row != 0) {
-					top = plane.vertices[row * subdivisions + col - subdivisions].pos;
-					isUp = 1;
-				}
-				else {
-					top = middle;
-					isUp = 0;
-				}
-				if (col != 0) {
-					left = plane.vertices[row * subdivisions + col - 1].pos;
-					isLeft = 1;
-				}
-				else {
-					left = middle;
-					isLeft = 0;
-				}
-				if (col != subdivisions) {
-					right = plane.vertices[row * subdivisions + col + 1].pos;
-					isRight = 1;
-				}
-				else {
-					right = middle;
-					isRight = 0;
-				}
-				if (row != subdivisions) {
-					bottom = plane.vertices[row * subdivisions + col + subdivisions].pos;
-					isDown = 1;
-				}
-				else {
-					bottom = middle;
-					isDown = 0;
-				}
-				
-				// Calculating the vectors from the middle to the other vertices
-				ew::Vec3 rightVec = right - middle;
-				ew::Vec3 upVec = top - middle;
-				ew::Vec3 botVec = middle - bottom;
-				ew::Vec3 leftVec = middle - left;
-				ew::Vec3 normal;
-				
-				// Calculating the normals based on what exists
-				if (isUp && isDown && isLeft && isRight) {
-					upVec = upVec + botVec;
-					rightVec = rightVec + leftVec;
-					normal = ew::Normalize(ew::Cross(upVec, rightVec));
-					
-				}
-				else if (!isUp) {
-					botVec = bottom - middle;
-					rightVec = rightVec + leftVec;
-					ew::Vec3 normal = ew::Normalize(ew::Cross(botVec, rightVec));
-				}
-				else if (!isDown) {
-					rightVec = rightVec + leftVec;
-					normal = ew::Normalize(ew::Cross(upVec, rightVec));
-				}
-				else if (!isRight) {
-					leftVec = left - middle;
-					upVec = upVec + botVec;
-					normal = ew::Normalize(ew::Cross(upVec, leftVec));
-				}
-				else if (!isLeft) {
-					upVec = upVec + botVec;
-					normal = ew::Normalize(ew::Cross(upVec, rightVec));
-				}
-				if (!isRight && !isUp) {
-					botVec = bottom - middle;
-					leftVec = left - middle;
-					normal = ew::Normalize(ew::Cross(botVec, leftVec));
-				}
-				else if (!isRight && !isDown) {
-					upVec = top - middle;
-					leftVec = left - middle;
-					normal = ew::Normalize(ew::Cross(upVec, leftVec));
-				}
-				else if (!isLeft && !isDown) {
-					upVec = top - middle;
-					rightVec = right - middle;
-					normal = ew::Normalize(ew::Cross(upVec, rightVec));
-				}
-				else if (!isLeft && !isUp){
-					botVec = bottom - middle;
-					rightVec = right - middle;
-					normal = ew::Normalize(ew::Cross(botVec, rightVec));
+		// LandNormals::FINITE_DIFFERENCES: central differences of the neighbouring vertices, one sided on the edges
+		auto buildNormals = [&](size_t band) {
+			const int beginRow = (int)band * LAND_ROWS_PER_BAND;
+			const int endRow = beginRow + LAND_ROWS_PER_BAND < numVertices ? beginRow + LAND_ROWS_PER_BAND : numVertices;
+			if (settings.cancel && settings.cancel->load(std::memory_order_relaxed))
+				return;
+			for (int row = beginRow; row < endRow; row++)
+			{
+				const ew::Vertex* current = &plane.vertices[row * numVertices];
+				const ew::Vertex* up = row != 0 ? current - numVertices : current;
+				const ew::Vertex* down = row != subdivisions ? current + numVertices : current;
+				for (int col = 0; col <= subdivisions; col++)
+				{
+					ew::Vec3 upVec = up[col].pos - down[col].pos; // towards +z
+					ew::Vec3 rightVec = current[col != subdivisions ? col + 1 : col].pos - current[col != 0 ? col - 1 : col].pos; // towards +x
+					plane.vertices[row * numVertices + col].normal = ew::Normalize(ew::Cross(upVec, rightVec));
 				}
-				
-				// Setting the normal at the point in question
-				plane.vertices[row * subdivisions + col].normal = normal;
-				
-
 			}
-		}
+		};
 
-		//indecies
-		float columbs = subdivisions + 1;
-		for (int row = 0; row < subdivisions; row++)
-		{
-			for (int col = 0; col < subdivisions; col++)
+		// Finite difference normals read the rows around them, so every band's vertices must exist first
+		if (pool) {
+			pool->parallelFor(numBands, buildRows);
+			if (!analyticNormals)
+				pool->parallelFor(numBands, buildNormals);
+		}
+		else {
+			for (int band = 0; band < numBands; band++)
 			{
-
-				unsigned int start = row * columbs + col;
-				//bottom triangle
-				plane.indices.push_back(start);
-				plane.indices.push_back(start + 1);
-				plane.indices.push_back(start + columbs + 1);
-				//bottom triangle
-				plane.indices.push_back(start);
-				plane.indices.push_back(start + columbs + 1);
-				plane.indices.push_back(start + columbs);
-
+				buildRows(band);
+			}
+			for (int band = 0; band < numBands && !analyticNormals; band++)
+			{
+				buildNormals(band);
 			}
 		}
 		return plane;
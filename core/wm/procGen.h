@@ -2,6 +2,7 @@
 #include "../ew/mesh.h"
 #include"../ew/ewMath/ewMath.h"
 #include "../wm/perlinNoise.h"
+#include <atomic>
 namespace wm
 {
 	ew::MeshData createSphere(float radius, int numSegments);
@@ -14,7 +15,29 @@ namespace wm
 
 	ew::MeshData createTorus(float innerRadius, float outerRadius, int sl, int st);
 
-	ew::MeshData createLand(float size, int subdivisions, int seed);
+	// How createLand computes vertex normals
+	enum class LandNormals {
+		ANALYTIC, // From the noise derivatives, evaluated together with the heights
+		FINITE_DIFFERENCES // From neighbouring vertex positions, a second pass over the grid
+	};
+
+	struct LandSettings {
+		ir::NoiseType noise = ir::NoiseType::PERLIN; // Height noise algorithm, noiseMode only applies to PERLIN
+		ir::PerlinNoise::Mode noiseMode = ir::PerlinNoise::Mode::TABLE; // LEGACY_HASH reproduces land generated before PerlinNoise used seeded tables
+		LandNormals normals = LandNormals::ANALYTIC;
+		// Global vertex index of the first row and column. Noise is sampled by global index, so chunks whose
+		// offsets are subdivisions apart share bit-identical border vertices (and normals, with ANALYTIC)
+		int rowOffset = 0;
+		int colOffset = 0;
+		// Checked before every band of rows. Once it is set createLand stops early and the mesh it returns is incomplete
+		const std::atomic<bool>* cancel = nullptr;
+	};
+
+	// createLand maps noise in [-1, 1] to heights in [0, LAND_HEIGHT_SCALE]
+	const float LAND_HEIGHT_SCALE = 10.0f;
+
+	// With a pool, rows are split across its threads. The mesh is byte-identical for any thread count
+	ew::MeshData createLand(float size, int subdivisions, int seed, const LandSettings& settings = LandSettings(), ew::ThreadPool* pool = nullptr);
 
 
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "simplexNoise.h"
+#include "../ew/ewMath/simd.h"
+
+// Skew from the square lattice to the triangle lattice and back
+static const float F2 = 0.36602540378f; // (sqrt(3) - 1) / 2
+static const float G2 = 0.21132486540f; // (3 - sqrt(3)) / 6
+static const float F3 = 1.0f / 3.0f;
+static const float G3 = 1.0f / 6.0f;
+// A corner contributes (0.5 - r^2)^4 * dot(gradient, offset). These scale the largest sum found by a numeric search to just under 1
+static const float SCALE_2D = 99.2f;
+static const float SCALE_3D = 76.8f;
+
+// The 12 cube edge directions
+static const float GRADIENTS_3D[12][3] = {
+	{ 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+	{ 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+	{ 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 }
+};
+
+ir::SimplexNoise::SimplexNoise(unsigned int seed) : m_seed(seed) {
+	for (int i = 0; i < 256; i++)
+	{
+		float angle = ew::TAU * i / 256;
+		m_gradients[i] = ew::Vec2(cos(angle), sin(angle));
+	}
+	buildPermutation(seed, m_permutation);
+}
+
+// One 2D sample. The region kernel below does the same operations in the same order, 4 samples at a time
+template<bool DERIVATIVES>
+static inline float simplex2D(const ir::SimplexNoise& simplex, float x, float y, float* ddx, float* ddy) {
+	// Triangle containing the point, and the point's offset from its three corners
+	float s = (x + y) * F2;
+	int i = (int)floor(x + s);
+	int j = (int)floor(y + s);
+	float t = (float)(i + j) * G2;
+	float x0 = x - ((float)i - t);
+	float y0 = y - ((float)j - t);
+	// Lower or upper triangle of the skewed square
+	int i1 = x0 > y0 ? 1 : 0;
+	int j1 = 1 - i1;
+	float cx[3] = { x0, x0 - (float)i1 + G2, x0 - 1.0f + 2.0f * G2 };
+	float cy[3] = { y0, y0 - (float)j1 + G2, y0 - 1.0f + 2.0f * G2 };
+	int gradIndex[3] = { simplex.gradIndex2D(i, j), simplex.gradIndex2D(i + i1, j + j1), simplex.gradIndex2D(i + 1, j + 1) };
+
+	float n = 0.0f, dx = 0.0f, dy = 0.0f;
+	for (int c = 0; c < 3; c++)
+	{
+		float falloff = 0.5f - cx[c] * cx[c] - cy[c] * cy[c];
+		falloff = falloff > 0.0f ? falloff : 0.0f;
+		const ew::Vec2& g = simplex.grad2D(gradIndex[c]);
+		float falloff2 = falloff * falloff;
+		float falloff4 = falloff2 * falloff2;
+		float gradDot = g.x * cx[c] + g.y * cy[c];
+		n += falloff4 * gradDot;
+		if (DERIVATIVES) {
+			// d/dx of falloff^4 * gradDot = falloff^4 * g.x - 8 * falloff^3 * gradDot * x
+			float a = 8.0f * falloff2 * falloff * gradDot;
+			dx += falloff4 * g.x - a * cx[c];
+			dy += falloff4 * g.y - a * cy[c];
+		}
+	}
+	if (DERIVATIVES) {
+		*ddx = dx * SCALE_2D;
+		*ddy = dy * SCALE_2D;
+	}
+	return n * SCALE_2D;
+}
+
+float ir::SimplexNoise::noise2D(float x, float y) {
+	return simplex2D<false>(*this, x, y, nullptr, nullptr);
+}
+
+float ir::SimplexNoise::noise2DDerivatives(float x, float y, float& ddx, float& ddy) {
+	return simplex2D<true>(*this, x, y, &ddx, &ddy);
+}
+
+float ir::SimplexNoise::noise3D(float x, float y, float z) {
+	float s = (x + y + z) * F3;
+	int i = (int)floor(x + s);
+	int j = (int)floor(y + s);
+	int k = (int)floor(z + s);
+	float t = (float)(i + j + k) * G3;
+	float x0 = x - ((float)i - t);
+	float y0 = y - ((float)j - t);
+	float z0 = z - ((float)k - t);
+
+	// Which of the six tetrahedra of the skewed cube: walk the axes from the largest offset to the smallest
+	int i1, j1, k1, i2, j2, k2;
+	if (x0 >= y0) {
+		if (y0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+		else if (x0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1; }
+		else { i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1; }
+	}
+	else {
+		if (y0 < z0) { i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1; }
+		else if (x0 < z0) { i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1; }
+		else { i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+	}
+	const int offsets[4][3] = { { 0, 0, 0 }, { i1, j1, k1 }, { i2, j2, k2 }, { 1, 1, 1 } };
+	const int ii = i & 255, jj = j & 255, kk = k & 255;
+
+	float n = 0.0f;
+	for (int c = 0; c < 4; c++)
+	{
+		float cx = x0 - (float)offsets[c][0] + c * G3;
+		float cy = y0 - (float)offsets[c][1] + c * G3;
+		float cz = z0 - (float)offsets[c][2] + c * G3;
+		float falloff = 0.5f - cx * cx - cy * cy - cz * cz;
+		if (falloff <= 0.0f)
+			continue;
+		int hash = m_permutation[ii + offsets[c][0] + m_permutation[jj + offsets[c][1] + m_permutation[kk + offsets[c][2]]]];
+		const float* g = GRADIENTS_3D[hash % 12];
+		falloff *= falloff;
+		n += falloff * falloff * (g[0] * cx + g[1] * cy + g[2] * cz);
+	}
+	return n * SCALE_3D;
+}
+
+// Rows of noise2D samples. With SSE the lattice search, corner offsets and falloff run on 4 samples at once,
+// only the permutation lookups of each lane's three corners are scalar (SSE2 has no gather)
+template<bool DERIVATIVES>
+static void evaluateRegion(const ir::SimplexNoise& simplex, float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) {
+	for (int j = beginY; j < endY; j++)
+	{
+		const float y = startY + j * stepY;
+		const size_t rowOffset = (size_t)(j - beginY) * outStride;
+		float* row = out + rowOffset;
+		float* rowDdx = DERIVATIVES ? outDdx + rowOffset : nullptr;
+		float* rowDdy = DERIVATIVES ? outDdy + rowOffset : nullptr;
+		int i = beginX;
+#if defined(EW_SIMD_SSE)
+		const __m128 vy = _mm_set1_ps(y), vStartX = _mm_set1_ps(startX), vStepX = _mm_set1_ps(stepX);
+		const __m128 vF2 = _mm_set1_ps(F2), vG2 = _mm_set1_ps(G2), vG2x2 = _mm_set1_ps(2.0f * G2);
+		const __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps(), eight = _mm_set1_ps(8.0f);
+		const __m128 scale = _mm_set1_ps(SCALE_2D);
+		const __m128i laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+		for (; i + 4 <= endX; i += 4)
+		{
+			const __m128 x = _mm_add_ps(vStartX, _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), laneOffsets)), vStepX));
+			const __m128 s = _mm_mul_ps(_mm_add_ps(x, vy), vF2);
+			// floor: truncate, then step down where truncation rounded a negative value up
+			const __m128 px = _mm_add_ps(x, s), py = _mm_add_ps(vy, s);
+			__m128i ci = _mm_cvttps_epi32(px), cj = _mm_cvttps_epi32(py);
+			ci = _mm_add_epi32(ci, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(ci), px)));
+			cj = _mm_add_epi32(cj, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(cj), py)));
+			const __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(ci, cj)), vG2);
+			const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(ci), t));
+			const __m128 y0 = _mm_sub_ps(vy, _mm_sub_ps(_mm_cvtepi32_ps(cj), t));
+			const __m128 upper = _mm_cmpgt_ps(x0, y0);
+			const __m128 i1 = _mm_and_ps(upper, one), j1 = _mm_andnot_ps(upper, one);
+			const __m128 cx[3] = { x0, _mm_add_ps(_mm_sub_ps(x0, i1), vG2), _mm_add_ps(_mm_sub_ps(x0, one), vG2x2) };
+			const __m128 cy[3] = { y0, _mm_add_ps(_mm_sub_ps(y0, j1), vG2), _mm_add_ps(_mm_sub_ps(y0, one), vG2x2) };
+
+			EW_ALIGN16 int laneI[4], laneJ[4];
+			_mm_store_si128((__m128i*)laneI, ci);
+			_mm_store_si128((__m128i*)laneJ, cj);
+			const int upperBits = _mm_movemask_ps(upper);
+			EW_ALIGN16 float gx[3][4], gy[3][4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				const int li1 = (upperBits >> lane) & 1;
+				const int index[3] = {
+					simplex.gradIndex2D(laneI[lane], laneJ[lane]),
+					simplex.gradIndex2D(laneI[lane] + li1, laneJ[lane] + 1 - li1),
+					simplex.gradIndex2D(laneI[lane] + 1, laneJ[lane] + 1)
+				};
+				for (int c = 0; c < 3; c++)
+				{
+					gx[c][lane] = simplex.grad2D(index[c]).x;
+					gy[c][lane] = simplex.grad2D(index[c]).y;
+				}
+			}
+
+			__m128 n = zero, dx = zero, dy = zero;
+			for (int c = 0; c < 3; c++)
+			{
+				__m128 falloff = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(cx[c], cx[c])), _mm_mul_ps(cy[c], cy[c]));
+				falloff = _mm_max_ps(falloff, zero);
+				const __m128 g0 = _mm_load_ps(gx[c]), g1 = _mm_load_ps(gy[c]);
+				const __m128 falloff2 = _mm_mul_ps(falloff, falloff);
+				const __m128 falloff4 = _mm_mul_ps(falloff2, falloff2);
+				const __m128 gradDot = _mm_add_ps(_mm_mul_ps(g0, cx[c]), _mm_mul_ps(g1, cy[c]));
+				n = _mm_add_ps(n, _mm_mul_ps(falloff4, gradDot));
+				if (DERIVATIVES) {
+					const __m128 a = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(eight, falloff2), falloff), gradDot);
+					dx = _mm_add_ps(dx, _mm_sub_ps(_mm_mul_ps(falloff4, g0), _mm_mul_ps(a, cx[c])));
+					dy = _mm_add_ps(dy, _mm_sub_ps(_mm_mul_ps(falloff4, g1), _mm_mul_ps(a, cy[c])));
+				}
+			}
+			_mm_storeu_ps(row + (i - beginX), _mm_mul_ps(n, scale));
+			if (DERIVATIVES) {
+				_mm_storeu_ps(rowDdx + (i - beginX), _mm_mul_ps(dx, scale));
+				_mm_storeu_ps(rowDdy + (i - beginX), _mm_mul_ps(dy, scale));
+			}
+		}
+#endif
+		// Remainder, and the whole row without SIMD
+		for (; i < endX; i++)
+		{
+			const float x = startX + i * stepX;
+			if (DERIVATIVES) {
+				row[i - beginX] = simplex2D<true>(simplex, x, y, &rowDdx[i - beginX], &rowDdy[i - beginX]);
+			}
+			else {
+				row[i - beginX] = simplex2D<false>(simplex, x, y, nullptr, nullptr);
+			}
+		}
+	}
+}
+
+void ir::SimplexNoise::noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) {
+	evaluateRegion<false>(*this, out, nullptr, nullptr, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY);
+}
+
+void ir::SimplexNoise::noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) {
+	evaluateRegion<true>(*this, out, outDdx, outDdy, outStride, beginX, endX, beginY, endY, startX, startY, stepX, stepY);
+}
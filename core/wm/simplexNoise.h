@@ -0,0 +1,28 @@
+#pragma once
+#include "../ew/ewMath/ewMath.h"
+#include "noise.h"
+
+namespace ir {
+	// Simplex noise: the plane is split into triangles (tetrahedra in 3D) instead of squares, so a sample
+	// only sums the falloff-weighted gradients of its three (four) corners. Same seeded tables as PerlinNoise's TABLE mode.
+	class SimplexNoise : public Noise {
+	public:
+		SimplexNoise(unsigned int seed = 0);
+		inline unsigned int getSeed()const { return m_seed; }
+
+		float noise2D(float x, float y) override;
+		float noise3D(float x, float y, float z) override;
+		float noise2DDerivatives(float x, float y, float& ddx, float& ddy) override;
+		// Samples along x are done 4 at a time with SSE, corner hashing stays scalar. Matches noise2D within float rounding
+		void noiseRegion(float* out, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) override;
+		void noiseRegionDerivatives(float* out, float* outDdx, float* outDdy, size_t outStride, int beginX, int endX, int beginY, int endY, float startX, float startY, float stepX, float stepY) override;
+
+		// Table index of the 2D gradient at a lattice point
+		inline int gradIndex2D(int i, int j)const { return m_permutation[(i & 255) + m_permutation[j & 255]]; }
+		inline const ew::Vec2& grad2D(int index)const { return m_gradients[index]; }
+	private:
+		unsigned int m_seed;
+		uint8_t m_permutation[512]; // Shuffled 0-255 twice so two lookups never need wrapping
+		ew::Vec2 m_gradients[256]; // Unit gradients evenly spaced around the circle
+	};
+}
@@ -2,11 +2,12 @@
 #include "../ew/ewMath/mat4.h"
 #include "../ew/ewMath/vec3.h"
 #include "../ew/ewMath/ewMath.h"
+#include "../ew/ewMath/transformations.h"
 
 
 namespace wm
 {
-	inline ew::Mat4 Identity()
+	constexpr ew::Mat4 Identity()
 	{
 		return ew::Mat4(
 			1, 0, 0, 0,
@@ -16,7 +17,7 @@ namespace wm
 
 	};
 
-	inline ew::Mat4 Sacle(ew::Vec3 s)
+	constexpr ew::Mat4 Sacle(ew::Vec3 s)
 	{
 		return ew::Mat4(
 			s.x, 0, 0, 0,
@@ -54,7 +55,7 @@ namespace wm
 		);
 			
 	};
-	inline ew::Mat4 Translate(ew::Vec3 t)
+	constexpr ew::Mat4 Translate(ew::Vec3 t)
 	{
 		return ew::Mat4(
 			1, 0, 0, t.x,
@@ -124,7 +125,8 @@ namespace wm
 		ew::Vec3 scale = ew::Vec3(1.0f, 1.0f, 1.0f);
 		ew::Mat4 getModelMatrix() const
 		{
-			return wm::Translate(position) * (RotateY(rotation.y) * RotateX(rotation.x) * RotateZ(rotation.z)) * Sacle(scale);
+			//Same as Translate * (RotateY * RotateX * RotateZ) * Sacle, composed in closed form
+			return ew::TRS(position, rotation, scale);
 		}
 	};
 